@@ -8,115 +8,131 @@
 
 const uint8_t c25519_base_x[F25519_SIZE] = {9};
 
-/* Double an X-coordinate */
-static void xc_double(uint8_t *x3, uint8_t *z3,
-		      const uint8_t *x1, const uint8_t *z1)
+/* Constant-time conditional swap of two field elements */
+static void xc_cswap(uint8_t *a, uint8_t *b, uint8_t condition)
 {
-	/* Explicit formulas database: dbl-1987-m
-	 *
-	 * source 1987 Montgomery "Speeding the Pollard and elliptic
-	 *   curve methods of factorization", page 261, fourth display
-	 * compute X3 = (X1^2-Z1^2)^2
-	 * compute Z3 = 4 X1 Z1 (X1^2 + a X1 Z1 + Z1^2)
-	 */
-	uint8_t x1sq[F25519_SIZE];
-	uint8_t z1sq[F25519_SIZE];
-	uint8_t x1z1[F25519_SIZE];
-	uint8_t a[F25519_SIZE];
-
-	f25519_mul__distinct(x1sq, x1, x1);
-	f25519_mul__distinct(z1sq, z1, z1);
-	f25519_mul__distinct(x1z1, x1, z1);
+	const uint8_t mask = -condition;
+	int i;
 
-	f25519_sub(a, x1sq, z1sq);
-	f25519_mul__distinct(x3, a, a);
+	for (i = 0; i < F25519_SIZE; i++) {
+		const uint8_t d = mask & (a[i] ^ b[i]);
 
-	f25519_mul_c(a, x1z1, 486662);
-	f25519_add(a, x1sq, a);
-	f25519_add(a, z1sq, a);
-	f25519_mul__distinct(x1sq, x1z1, a);
-	f25519_mul_c(z3, x1sq, 4);
+		a[i] ^= d;
+		b[i] ^= d;
+	}
 }
 
-/* Differential addition */
-static void xc_diffadd(uint8_t *x5, uint8_t *z5,
-		       const uint8_t *x1, const uint8_t *z1,
-		       const uint8_t *x2, const uint8_t *z2,
-		       const uint8_t *x3, const uint8_t *z3)
+/* Combined ladder step: from P_m = (x2:z2) and P_(m+1) = (x3:z3), with
+ * difference q, compute P_(2m) in (x2:z2) and P_(2m+1) in (x3:z3).
+ */
+static void xc_ladderstep(uint8_t *x2, uint8_t *z2,
+			  uint8_t *x3, uint8_t *z3, const uint8_t *q)
 {
-	/* Explicit formulas database: dbl-1987-m3
+	/* Explicit formulas database: ladd-1987-m-3
 	 *
-	 * source 1987 Montgomery "Speeding the Pollard and elliptic curve
-	 *   methods of factorization", page 261, fifth display, plus
-	 *   common-subexpression elimination
+	 * source 1987 Montgomery "Speeding the Pollard and elliptic
+	 *   curve methods of factorization", page 261, fifth and sixth
+	 *   displays, plus common-subexpression elimination
+	 * assume Z1 = 1
+	 * parameter a24 = (A+2)/4 = 121666
 	 * compute A = X2+Z2
+	 * compute AA = A^2
 	 * compute B = X2-Z2
+	 * compute BB = B^2
+	 * compute E = AA-BB
 	 * compute C = X3+Z3
 	 * compute D = X3-Z3
 	 * compute DA = D A
 	 * compute CB = C B
-	 * compute X5 = Z1(DA+CB)^2
+	 * compute X5 = (DA+CB)^2
 	 * compute Z5 = X1(DA-CB)^2
+	 * compute X4 = AA BB
+	 * compute Z4 = E(BB + a24 E)
+	 *
+	 * 5M + 4S + 1 multiplication by a small constant.
 	 */
-	uint8_t da[F25519_SIZE];
-	uint8_t cb[F25519_SIZE];
 	uint8_t a[F25519_SIZE];
+	uint8_t aa[F25519_SIZE];
 	uint8_t b[F25519_SIZE];
+	uint8_t bb[F25519_SIZE];
+	uint8_t e[F25519_SIZE];
+	uint8_t c[F25519_SIZE];
+	uint8_t d[F25519_SIZE];
+	uint8_t da[F25519_SIZE];
+	uint8_t cb[F25519_SIZE];
 
 	f25519_add(a, x2, z2);
-	f25519_sub(b, x3, z3); /* D */
-	f25519_mul__distinct(da, a, b);
-
+	f25519_mul__distinct(aa, a, a);
 	f25519_sub(b, x2, z2);
-	f25519_add(a, x3, z3); /* C */
-	f25519_mul__distinct(cb, a, b);
-
-	f25519_add(a, da, cb);
-	f25519_mul__distinct(b, a, a);
-	f25519_mul__distinct(x5, z1, b);
-
-	f25519_sub(a, da, cb);
-	f25519_mul__distinct(b, a, a);
-	f25519_mul__distinct(z5, x1, b);
+	f25519_mul__distinct(bb, b, b);
+	f25519_sub(e, aa, bb);
+
+	f25519_add(c, x3, z3);
+	f25519_sub(d, x3, z3);
+	f25519_mul__distinct(da, d, a);
+	f25519_mul__distinct(cb, c, b);
+
+	/* P_(2m+1) */
+	f25519_add(c, da, cb);
+	f25519_mul__distinct(x3, c, c);
+	f25519_sub(d, da, cb);
+	f25519_mul__distinct(c, d, d);
+	f25519_mul__distinct(z3, q, c);
+
+	/* P_(2m) */
+	f25519_mul__distinct(x2, aa, bb);
+	f25519_mul_c(c, e, 121666);
+	f25519_add(c, bb, c);
+	f25519_mul__distinct(z2, e, c);
 }
 
-void c25519_smult(uint8_t *result, const uint8_t *q, const uint8_t *e)
+void c25519_smult_xz(uint8_t *x2, uint8_t *z2, uint8_t *x3, uint8_t *z3,
+		     const uint8_t *q, const uint8_t *e)
 {
-	/* Current point: P_m */
-	uint8_t xm[F25519_SIZE];
-	uint8_t zm[F25519_SIZE] = {1};
-
-	/* Predecessor: P_(m-1) */
-	uint8_t xm1[F25519_SIZE] = {1};
-	uint8_t zm1[F25519_SIZE] = {0};
-
+	uint8_t swap;
 	int i;
 
-	/* Note: bit 254 is assumed to be 1 */
-	f25519_copy(xm, q);
+	/* P_m starts at P_1 = (q:1), its successor at P_0 = (1:0) */
+	f25519_copy(x2, q);
+	f25519_load(z2, 1);
+	f25519_load(x3, 1);
+	f25519_load(z3, 0);
 
-	for (i = 253; i >= 0; i--) {
-		const int bit = (e[i >> 3] >> (i & 7)) & 1;
-		uint8_t xms[F25519_SIZE];
-		uint8_t zms[F25519_SIZE];
-
-		/* From P_m and P_(m-1), compute P_(2m) and P_(2m-1) */
-		xc_diffadd(xm1, zm1, q, f25519_one, xm, zm, xm1, zm1);
-		xc_double(xm, zm, xm, zm);
+	/* Note: bit 254 is assumed to be 1. Stepping on (P_1, P_0) leaves
+	 * (P_2, P_1), which is the m = 1 state with the pair swapped.
+	 */
+	xc_ladderstep(x2, z2, x3, z3, q);
+	swap = 1;
 
-		/* Compute P_(2m+1) */
-		xc_diffadd(xms, zms, xm1, zm1, xm, zm, q, f25519_one);
+	for (i = 253; i >= 0; i--) {
+		const uint8_t bit = (e[i >> 3] >> (i & 7)) & 1;
 
-		/* Select:
-		 *   bit = 1 --> (P_(2m+1), P_(2m))
-		 *   bit = 0 --> (P_(2m), P_(2m-1))
+		/* Step on (P_m, P_(m+1)) if bit = 0, giving
+		 * (P_(2m), P_(2m+1)), or on (P_(m+1), P_m) if bit = 1,
+		 * giving (P_(2m+2), P_(2m+1)). The swap is applied lazily,
+		 * only when it differs from the previous bit.
 		 */
-		f25519_select(xm1, xm1, xm, bit);
-		f25519_select(zm1, zm1, zm, bit);
-		f25519_select(xm, xm, xms, bit);
-		f25519_select(zm, zm, zms, bit);
+		swap ^= bit;
+		xc_cswap(x2, x3, swap);
+		xc_cswap(z2, z3, swap);
+		swap = bit;
+
+		xc_ladderstep(x2, z2, x3, z3, q);
 	}
 
+	xc_cswap(x2, x3, swap);
+	xc_cswap(z2, z3, swap);
+}
+
+void c25519_smult(uint8_t *result, const uint8_t *q, const uint8_t *e)
+{
+	uint8_t xm[F25519_SIZE];
+	uint8_t zm[F25519_SIZE];
+	uint8_t xm1[F25519_SIZE];
+	uint8_t zm1[F25519_SIZE];
+
+	c25519_smult_xz(xm, zm, xm1, zm1, q, e);
+
 	/* Freeze out of projective coordinates */
 	f25519_inv__distinct(zm1, zm);
 	f25519_mul__distinct(result, zm1, xm);
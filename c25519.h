@@ -45,4 +45,11 @@ extern const uint8_t c25519_base_x[F25519_SIZE];
  */
 void c25519_smult(uint8_t *result, const uint8_t *q, const uint8_t *e);
 
+/* As above, but stop short of the final inversion. On return, (x2:z2)
+ * is the projective X-coordinate of e*q and (x3:z3) is that of (e+1)*q.
+ * The pair is what's needed to recover the Y-coordinate of e*q.
+ */
+void c25519_smult_xz(uint8_t *x2, uint8_t *z2, uint8_t *x3, uint8_t *z3,
+		     const uint8_t *q, const uint8_t *e);
+
 #endif
@@ -0,0 +1,155 @@
+/* Persistent, memory-mapped discrete-log tables
+ *
+ * This file is in the public domain.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dlog-file.h"
+
+static const char dlog_file_magic[8] = {
+	'S', 'U', 'M', 'F', 'E', 'D', 'L', 'G'
+};
+
+static void put32(uint8_t *b, uint32_t v)
+{
+	b[0] = v;
+	b[1] = v >> 8;
+	b[2] = v >> 16;
+	b[3] = v >> 24;
+}
+
+static uint32_t get32(const uint8_t *b)
+{
+	return ((uint32_t)b[0]) |
+	       (((uint32_t)b[1]) << 8) |
+	       (((uint32_t)b[2]) << 16) |
+	       (((uint32_t)b[3]) << 24);
+}
+
+/* The slot array is stored as the in-memory image, so the host must
+ * use the same (little-endian) byte order as the file.
+ */
+static int host_is_le(void)
+{
+	const uint16_t one = 1;
+
+	return *(const uint8_t *)&one == 1;
+}
+
+static void make_header(uint8_t *hdr, uint32_t m, uint32_t nslots,
+			const struct ed25519_pt *base)
+{
+	memset(hdr, 0, DLOG_FILE_HEADER_SIZE);
+	memcpy(hdr, dlog_file_magic, sizeof(dlog_file_magic));
+	put32(hdr + 8, DLOG_FILE_VERSION);
+	put32(hdr + 12, DLOG_FILE_HEADER_SIZE);
+	dlog_encode(hdr + 16, base);
+	put32(hdr + 48, m);
+	put32(hdr + 52, nslots);
+	put32(hdr + 56, sizeof(struct dlog_entry));
+	put32(hdr + 60, DLOG_HASH_ID);
+	put32(hdr + 64, DLOG_FILE_DATA_OFFSET);
+}
+
+int dlog_file_save(const char *path, const struct dlog_table *t,
+		   const struct ed25519_pt *base)
+{
+	static const uint8_t pad[DLOG_FILE_DATA_OFFSET - DLOG_FILE_HEADER_SIZE];
+	uint8_t hdr[DLOG_FILE_HEADER_SIZE];
+	FILE *out;
+	int ok;
+
+	/* Only the full layout is stored */
+	if (!host_is_le() || !t->slots)
+		return 0;
+
+	out = fopen(path, "wb");
+	if (!out)
+		return 0;
+
+	make_header(hdr, t->m, t->nslots, base);
+	ok = fwrite(hdr, sizeof(hdr), 1, out) == 1 &&
+	     fwrite(pad, sizeof(pad), 1, out) == 1 &&
+	     fwrite(t->slots, sizeof(*t->slots), t->nslots, out) == t->nslots;
+
+	if (fclose(out))
+		ok = 0;
+
+	return ok;
+}
+
+int dlog_file_map(struct dlog_table *t, struct dlog_file_map *map,
+		  const char *path, const struct ed25519_pt *base)
+{
+	uint8_t want[DLOG_FILE_HEADER_SIZE];
+	const uint8_t *hdr;
+	struct stat st;
+	uint32_t m, nslots;
+	void *addr;
+	int fd;
+
+	if (!host_is_le())
+		return 0;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 0;
+
+	if (fstat(fd, &st) < 0 || st.st_size < DLOG_FILE_DATA_OFFSET) {
+		close(fd);
+		return 0;
+	}
+
+	addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+		return 0;
+
+	/* Check everything but m and the slot count against what this
+	 * build would write. t is left alone until every check passes.
+	 */
+	hdr = addr;
+	m = get32(hdr + 48);
+	nslots = get32(hdr + 52);
+	make_header(want, m, nslots, base);
+
+	/* The slot count follows from m, and the file must hold exactly
+	 * that many slots, as dlog_file_save() writes them.
+	 */
+	if (memcmp(hdr, want, DLOG_FILE_HEADER_SIZE) || !m ||
+	    m > UINT32_MAX / 2 || nslots != DLOG_TABLE_SLOTS(m) ||
+	    (uint64_t)st.st_size != DLOG_FILE_DATA_OFFSET +
+	    (uint64_t)nslots * sizeof(struct dlog_entry)) {
+		munmap(addr, st.st_size);
+		return 0;
+	}
+
+	/* Lookups land on random slots. Ask for huge pages where the
+	 * kernel supports them for file mappings, to cut TLB misses, and
+	 * don't bother reading ahead.
+	 */
+#ifdef MADV_HUGEPAGE
+	madvise(addr, st.st_size, MADV_HUGEPAGE);
+#endif
+	madvise(addr, st.st_size, MADV_RANDOM);
+
+	map->addr = addr;
+	map->len = st.st_size;
+
+	dlog_table_attach(t, (const struct dlog_entry *)
+			  ((const uint8_t *)addr + DLOG_FILE_DATA_OFFSET),
+			  nslots, m, base);
+	return 1;
+}
+
+void dlog_file_unmap(struct dlog_file_map *map)
+{
+	munmap(map->addr, map->len);
+	map->addr = NULL;
+	map->len = 0;
+}
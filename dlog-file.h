@@ -0,0 +1,58 @@
+/* Persistent, memory-mapped discrete-log tables
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef DLOG_FILE_H_
+#define DLOG_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dlog.h"
+
+/* On-disk format, all fields little-endian:
+ *
+ *     0     magic "SUMFEDLG"
+ *     8     format version (DLOG_FILE_VERSION)
+ *     12    header size
+ *     16    compressed base point, identifying the curve and generator
+ *     48    m, the number of baby steps (and giant step size)
+ *     52    number of slots
+ *     56    size of one slot
+ *     60    slot hash (DLOG_HASH_ID)
+ *     64    offset of the slot array
+ *
+ * The slot array is an image of the in-memory struct dlog_entry array,
+ * starting on a page boundary, so it can be used in place once mapped.
+ * The loader maps it read-only and shared, so any number of processes
+ * on a host use one copy in the page cache, and decryption is ready as
+ * soon as the file is opened.
+ *
+ * This needs POSIX mmap(), and so is only built for the native target.
+ */
+#define DLOG_FILE_VERSION      1
+#define DLOG_FILE_HEADER_SIZE  128
+#define DLOG_FILE_DATA_OFFSET  4096
+
+struct dlog_file_map {
+	void    *addr;
+	size_t  len;
+};
+
+/* Write a full-layout table to path. Returns 1 on success, 0 on failure. */
+int dlog_file_save(const char *path, const struct dlog_table *t,
+		   const struct ed25519_pt *base);
+
+/* Map a table from path. The header must match the running code's
+ * format version, slot layout, hash and base point, and the file size
+ * must match m. The table's slots are read-only, and stay valid until
+ * dlog_file_unmap() is called.
+ * Returns 1 on success, 0 on failure.
+ */
+int dlog_file_map(struct dlog_table *t, struct dlog_file_map *map,
+		  const char *path, const struct ed25519_pt *base);
+
+void dlog_file_unmap(struct dlog_file_map *map);
+
+#endif
@@ -0,0 +1,213 @@
+/* Resident discrete-log decryption service
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdlib.h>
+
+#include "dlog-service.h"
+#include "fe-parallel.h"
+#include "kangaroo.h"
+
+struct solve_job {
+	const struct dlog_table		*table;
+	const struct ed25519_pt		*targets;
+	unsigned int			n;
+	uint64_t			bound;
+	uint64_t			*v;
+	uint8_t				*found;
+	unsigned int			solved;
+};
+
+static void solve_worker(void *arg, unsigned int idx, unsigned int nthreads)
+{
+	struct solve_job *job = arg;
+	unsigned int begin, end, i;
+	unsigned int solved = 0;
+	void *scratch;
+
+	tpool_range(job->n, idx, nthreads, &begin, &end);
+	if (begin == end)
+		return;
+
+	scratch = malloc(DLOG_BATCH_SCRATCH(DLOG_SERVICE_BATCH));
+	if (!scratch) {
+		for (i = begin; i < end; i++)
+			job->found[i] = 0;
+		return;
+	}
+
+	for (i = begin; i < end; i += DLOG_SERVICE_BATCH) {
+		const unsigned int n = (end - i < DLOG_SERVICE_BATCH) ?
+			end - i : DLOG_SERVICE_BATCH;
+
+		solved += dlog_solve_batch(job->table, job->targets + i, n,
+					   job->bound, job->v + i,
+					   job->found + i, scratch);
+	}
+
+	free(scratch);
+	__atomic_add_fetch(&job->solved, solved, __ATOMIC_RELAXED);
+}
+
+struct signed_job {
+	const struct dlog_table		*table;
+	const struct ed25519_pt		*targets;
+	unsigned int			n;
+	uint64_t			bound;
+	int64_t				*v;
+	uint8_t				*found;
+	unsigned int			solved;
+};
+
+static void signed_worker(void *arg, unsigned int idx, unsigned int nthreads)
+{
+	struct signed_job *job = arg;
+	unsigned int begin, end, i;
+	unsigned int solved = 0;
+
+	tpool_range(job->n, idx, nthreads, &begin, &end);
+
+	for (i = begin; i < end; i++) {
+		job->found[i] = dlog_solve_signed(job->table, &job->targets[i],
+						  job->bound, &job->v[i]);
+		solved += job->found[i];
+	}
+
+	__atomic_add_fetch(&job->solved, solved, __ATOMIC_RELAXED);
+}
+
+int dlog_service_init(struct dlog_service *s, struct tpool *pool,
+		      uint32_t m, const char *path,
+		      const struct ed25519_pt *base)
+{
+	s->pool = pool;
+	s->storage = NULL;
+	s->mapped = path && dlog_file_map(&s->table, &s->map, path, base);
+
+	if (s->mapped)
+		return 1;
+
+	s->storage = malloc(DLOG_COMPACT_BUCKETS((size_t)m) *
+			    sizeof(struct dlog_bucket));
+	if (s->storage) {
+		dlog_table_init(&s->table, NULL, s->storage, m, base);
+		if (fe_dlog_build_parallel(pool, &s->table))
+			return 1;
+		free(s->storage);
+	}
+
+	s->storage = malloc(DLOG_TABLE_SLOTS((size_t)m) *
+			    sizeof(struct dlog_entry));
+	if (s->storage) {
+		dlog_table_init(&s->table, s->storage, NULL, m, base);
+		if (fe_dlog_build_parallel(pool, &s->table))
+			return 1;
+		free(s->storage);
+		s->storage = NULL;
+	}
+
+	return 0;
+}
+
+unsigned int dlog_service_solve(struct dlog_service *s,
+				const struct ed25519_pt *targets,
+				unsigned int n, uint64_t bound,
+				uint64_t *v, uint8_t *found)
+{
+	struct solve_job job;
+	unsigned int i;
+
+	/* Past 4m^2, bound/m giant steps cost more than the 2*sqrt(bound)
+	 * steps of a kangaroo search.
+	 */
+	if (bound / s->table.m > 4 * (uint64_t)s->table.m) {
+		const struct kangaroo_cfg cfg = {
+			KANGAROO_DEFAULT_WALKERS, 0, 0
+		};
+		unsigned int solved = 0;
+
+		for (i = 0; i < n; i++) {
+			found[i] = kangaroo_solve(s->pool, &cfg,
+						  &s->table.base, &targets[i],
+						  bound, &v[i]);
+			solved += found[i];
+		}
+
+		return solved;
+	}
+
+	job.table = &s->table;
+	job.targets = targets;
+	job.n = n;
+	job.bound = bound;
+	job.v = v;
+	job.found = found;
+	job.solved = 0;
+
+	tpool_run(s->pool, solve_worker, &job);
+
+	return job.solved;
+}
+
+unsigned int dlog_service_solve_signed(struct dlog_service *s,
+				       const struct ed25519_pt *targets,
+				       unsigned int n, uint64_t bound,
+				       int64_t *v, uint8_t *found)
+{
+	struct signed_job job;
+	unsigned int i;
+
+	if (2 * bound / s->table.m > 4 * (uint64_t)s->table.m) {
+		const struct kangaroo_cfg cfg = {
+			KANGAROO_DEFAULT_WALKERS, 0, 0
+		};
+		uint8_t e[ED25519_EXPONENT_SIZE] = {0};
+		struct ed25519_pt shift;
+		unsigned int solved = 0;
+
+		/* shift = bound*base, so that target + shift is
+		 * (v + bound)*base with 0 <= v + bound <= 2*bound.
+		 */
+		for (i = 0; i < 8; i++)
+			e[i] = bound >> (i * 8);
+		ed25519_smult_bounded(&shift, &s->table.base, e, 64);
+
+		for (i = 0; i < n; i++) {
+			struct ed25519_pt t;
+			uint64_t u;
+
+			ed25519_add(&t, &targets[i], &shift);
+			found[i] = kangaroo_solve(s->pool, &cfg,
+						  &s->table.base, &t,
+						  2 * bound, &u);
+			if (found[i])
+				v[i] = (int64_t)u - (int64_t)bound;
+			solved += found[i];
+		}
+
+		return solved;
+	}
+
+	job.table = &s->table;
+	job.targets = targets;
+	job.n = n;
+	job.bound = bound;
+	job.v = v;
+	job.found = found;
+	job.solved = 0;
+
+	tpool_run(s->pool, signed_worker, &job);
+
+	return job.solved;
+}
+
+void dlog_service_destroy(struct dlog_service *s)
+{
+	if (s->mapped)
+		dlog_file_unmap(&s->map);
+
+	free(s->storage);
+	s->storage = NULL;
+	s->mapped = 0;
+}
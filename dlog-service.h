@@ -0,0 +1,76 @@
+/* Resident discrete-log decryption service
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef DLOG_SERVICE_H_
+#define DLOG_SERVICE_H_
+
+#include <stdint.h>
+
+#include "dlog.h"
+#include "dlog-file.h"
+#include "tpool.h"
+
+/* A long-lived solver for many decryption queries against the same
+ * population. The baby-step table is set up once, mapped from a stored
+ * file if one is given and matches, or else built in parallel in the
+ * compact layout. Queries arrive in batches: the batch is split across
+ * the pool threads, and each thread advances the giant-step walks of up
+ * to DLOG_SERVICE_BATCH targets together with dlog_solve_batch(), so
+ * that a step costs one inversion per batch rather than per target.
+ *
+ * Bounds too large for the table are handed to the kangaroo solver one
+ * target at a time. A walk takes bound/m giant steps against about
+ * 2*sqrt(bound) kangaroo steps, so the switch is at 4m^2. Below that the
+ * table is also exact, while kangaroo can miss.
+ *
+ * This needs POSIX threads, and so is only built for the native
+ * target.
+ */
+#define DLOG_SERVICE_BATCH  256
+
+struct dlog_service {
+	struct tpool		*pool;
+	struct dlog_table	table;
+
+	/* Table storage when built here, or NULL */
+	void			*storage;
+
+	/* Table mapping when loaded from a file */
+	struct dlog_file_map	map;
+	int			mapped;
+};
+
+/* Set up a service with m baby steps for base. path names a stored
+ * table to try first, or is NULL. Returns 1 on success, 0 if the table
+ * could be neither mapped nor built.
+ */
+int dlog_service_init(struct dlog_service *s, struct tpool *pool,
+		      uint32_t m, const char *path,
+		      const struct ed25519_pt *base);
+
+/* Solve targets[i] = v[i]*base for 0 <= v[i] <= bound. found[i] is set
+ * to 1 for each target solved, and 0 otherwise. Returns the number of
+ * targets solved.
+ */
+unsigned int dlog_service_solve(struct dlog_service *s,
+				const struct ed25519_pt *targets,
+				unsigned int n, uint64_t bound,
+				uint64_t *v, uint8_t *found);
+
+/* As dlog_service_solve(), for signed v[i], -bound <= v[i] <= bound
+ * (bound less than 2^59). Within the table's reach, each target gets a
+ * centered search with dlog_solve_signed(). Past it, the target is
+ * shifted by bound*base, and the kangaroo solver searches the unsigned
+ * range [0, 2*bound]: the switch is where it would be for an unsigned
+ * bound of 2*bound.
+ */
+unsigned int dlog_service_solve_signed(struct dlog_service *s,
+				       const struct ed25519_pt *targets,
+				       unsigned int n, uint64_t bound,
+				       int64_t *v, uint8_t *found);
+
+void dlog_service_destroy(struct dlog_service *s);
+
+#endif
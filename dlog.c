@@ -0,0 +1,565 @@
+/* Bounded discrete logarithms on the Edwards curve
+ *
+ * This file is in the public domain.
+ */
+
+#include "dlog.h"
+
+void dlog_encode(uint8_t *key, const struct ed25519_pt *p)
+{
+	uint8_t x[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+
+	ed25519_unproject(x, y, p);
+	ed25519_pack(key, x, y);
+}
+
+/* Maximum displacements when placing a compact entry */
+#define DLOG_MAX_KICKS  500
+
+/* Index of a compact slot claimed but not yet filled in */
+#define DLOG_IDX_PENDING  0xffffffffU
+
+static uint32_t load32(const uint8_t *b)
+{
+	return ((uint32_t)b[0]) |
+	       (((uint32_t)b[1]) << 8) |
+	       (((uint32_t)b[2]) << 16) |
+	       (((uint32_t)b[3]) << 24);
+}
+
+/* Map a uniform 32-bit value onto [0, n) without a division */
+static uint32_t dlog_scale(uint32_t h, uint32_t n)
+{
+	return (uint32_t)((((uint64_t)h) * n) >> 32);
+}
+
+/* The low bytes of the compressed point are those of y, which are
+ * already uniformly distributed.
+ */
+static uint32_t dlog_slot(const struct dlog_table *t, const uint8_t *key)
+{
+	return dlog_scale(load32(key), t->nslots);
+}
+
+static uint32_t dlog_fingerprint(const uint8_t *key)
+{
+	const uint32_t fp = load32(key + 4);
+
+	return fp ? fp : 1;
+}
+
+/* The two buckets of a fingerprint sum to a value that depends only on
+ * it, so either one gives the other.
+ */
+static uint32_t dlog_alt_bucket(const struct dlog_table *t, uint32_t b,
+				uint32_t fp)
+{
+	const uint32_t h = dlog_scale(fp * 0x5bd1e995U, t->nbuckets);
+
+	return h >= b ? h - b : h + t->nbuckets - b;
+}
+
+static int dlog_insert_full(struct dlog_table *t, const uint8_t *key,
+			    uint32_t idx)
+{
+	uint32_t i = dlog_slot(t, key);
+	uint32_t n;
+
+	if (!t->fill)
+		return 0;
+
+	for (n = 0; n < t->nslots; n++) {
+		uint32_t empty = 0;
+
+		if (!__atomic_load_n(&t->fill[i].idx, __ATOMIC_RELAXED) &&
+		    __atomic_compare_exchange_n(&t->fill[i].idx, &empty, idx,
+						0, __ATOMIC_ACQ_REL,
+						__ATOMIC_RELAXED)) {
+			memcpy(t->fill[i].key, key, ED25519_PACK_SIZE);
+			return 1;
+		}
+
+		if (++i == t->nslots)
+			i = 0;
+	}
+
+	return 0;
+}
+
+/* Claim an empty slot of a bucket */
+static int dlog_claim(struct dlog_bucket *k, uint32_t fp, uint32_t idx)
+{
+	int w;
+
+	for (w = 0; w < DLOG_BUCKET_WAYS; w++) {
+		uint32_t empty = 0;
+
+		if (!__atomic_load_n(&k->fp[w], __ATOMIC_RELAXED) &&
+		    __atomic_compare_exchange_n(&k->fp[w], &empty, fp, 0,
+						__ATOMIC_ACQ_REL,
+						__ATOMIC_RELAXED)) {
+			__atomic_store_n(&k->idx[w], idx, __ATOMIC_RELEASE);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Place a compact entry. Empty slots are claimed lock-free. When both
+ * buckets are full, entries are displaced under t->lock, which only
+ * serializes displacement chains against each other.
+ */
+static int dlog_insert_compact(struct dlog_table *t, const uint8_t *key,
+			       uint32_t idx)
+{
+	uint32_t fp = dlog_fingerprint(key);
+	uint32_t b = dlog_scale(load32(key), t->nbuckets);
+	unsigned int victim = 0;
+	int ret = 0;
+	int n;
+
+	if (dlog_claim(&t->buckets[b], fp, idx) ||
+	    dlog_claim(&t->buckets[dlog_alt_bucket(t, b, fp)], fp, idx))
+		return 1;
+
+	while (__atomic_exchange_n(&t->lock, 1, __ATOMIC_ACQUIRE))
+		;
+
+	for (n = 0; n < DLOG_MAX_KICKS; n++) {
+		const uint32_t alt = dlog_alt_bucket(t, b, fp);
+		struct dlog_bucket *k = &t->buckets[alt];
+		uint32_t tmp;
+		int w;
+
+		if (dlog_claim(&t->buckets[b], fp, idx) ||
+		    dlog_claim(k, fp, idx)) {
+			ret = 1;
+			break;
+		}
+
+		/* Both full: evict a slot of the alternate bucket, and
+		 * carry its entry on to its own alternate. The slot may
+		 * have been claimed but not yet given its index.
+		 */
+		w = victim++ % DLOG_BUCKET_WAYS;
+
+		while ((tmp = __atomic_load_n(&k->idx[w], __ATOMIC_ACQUIRE)) ==
+		       DLOG_IDX_PENDING)
+			;
+		__atomic_store_n(&k->idx[w], idx, __ATOMIC_RELAXED);
+		idx = tmp;
+
+		tmp = __atomic_load_n(&k->fp[w], __ATOMIC_RELAXED);
+		__atomic_store_n(&k->fp[w], fp, __ATOMIC_RELAXED);
+		fp = tmp;
+
+		b = alt;
+	}
+
+	__atomic_store_n(&t->lock, 0, __ATOMIC_RELEASE);
+	return ret;
+}
+
+int dlog_table_insert(struct dlog_table *t, const uint8_t *key, uint32_t j)
+{
+	if (t->buckets)
+		return dlog_insert_compact(t, key, j);
+
+	return dlog_insert_full(t, key, j + 1);
+}
+
+/* Compare a stored key with a looked-up one. With neg == NULL they must
+ * be equal. Otherwise only y must match, and *neg is set if the x signs
+ * differ, meaning the looked-up point is the negation of the stored one.
+ */
+static int dlog_match(const uint8_t *stored, const uint8_t *key, int *neg)
+{
+	const uint8_t diff = stored[ED25519_PACK_SIZE - 1] ^
+			     key[ED25519_PACK_SIZE - 1];
+
+	if ((diff & 0x7f) || memcmp(stored, key, ED25519_PACK_SIZE - 1))
+		return 0;
+
+	if (!neg)
+		return !diff;
+
+	*neg = diff >> 7;
+	return 1;
+}
+
+/* Confirm that key is j*base (or its negation, see dlog_match()) */
+static int dlog_confirm(const struct dlog_table *t, const uint8_t *key,
+			uint32_t j, int *neg)
+{
+	uint8_t e[ED25519_EXPONENT_SIZE];
+	uint8_t c[ED25519_PACK_SIZE];
+	struct ed25519_pt p;
+
+	f25519_load(e, j);
+	ed25519_smult_bounded(&p, &t->base, e, 32);
+	dlog_encode(c, &p);
+
+	return dlog_match(c, key, neg);
+}
+
+/* Bucket and probe positions depend on y alone, so P and -P are found
+ * by the same search.
+ */
+static uint32_t dlog_find(const struct dlog_table *t, const uint8_t *key,
+			  int *neg)
+{
+	uint32_t i, n;
+
+	if (t->buckets) {
+		const uint32_t fp = dlog_fingerprint(key);
+		uint32_t b[2];
+		int w;
+
+		b[0] = dlog_scale(load32(key), t->nbuckets);
+		b[1] = dlog_alt_bucket(t, b[0], fp);
+
+		for (i = 0; i < 2; i++) {
+			const struct dlog_bucket *k = &t->buckets[b[i]];
+
+			for (w = 0; w < DLOG_BUCKET_WAYS; w++)
+				if (k->fp[w] == fp && k->idx[w] < t->m &&
+				    dlog_confirm(t, key, k->idx[w], neg))
+					return k->idx[w] + 1;
+		}
+
+		return 0;
+	}
+
+	/* The probe count is capped, so a table without an empty slot
+	 * (such as a corrupt file) can't make this loop forever.
+	 */
+	i = dlog_slot(t, key);
+
+	for (n = 0; n < t->nslots && t->slots[i].idx; n++) {
+		if (dlog_match(t->slots[i].key, key, neg))
+			return (t->slots[i].idx <= t->m) ? t->slots[i].idx : 0;
+
+		if (++i == t->nslots)
+			i = 0;
+	}
+
+	return 0;
+}
+
+uint32_t dlog_table_find(const struct dlog_table *t, const uint8_t *key)
+{
+	return dlog_find(t, key, NULL);
+}
+
+uint32_t dlog_table_find_signed(const struct dlog_table *t,
+				const uint8_t *key, int *neg)
+{
+	return dlog_find(t, key, neg);
+}
+
+/* Set the base and the giant step -m*base. -(x, y) = (-x, y) */
+static void dlog_set_base(struct dlog_table *t, uint32_t m,
+			  const struct ed25519_pt *base)
+{
+	uint8_t e[ED25519_EXPONENT_SIZE];
+
+	t->m = m;
+	ed25519_copy(&t->base, base);
+
+	f25519_load(e, m);
+	ed25519_smult_bounded(&t->giant, base, e, 32);
+	f25519_neg(t->giant.x, t->giant.x);
+	f25519_neg(t->giant.t, t->giant.t);
+}
+
+void dlog_table_init(struct dlog_table *t, struct dlog_entry *slots,
+		     struct dlog_bucket *buckets, uint32_t m,
+		     const struct ed25519_pt *base)
+{
+	uint32_t i;
+
+	if (buckets) {
+		t->slots = NULL;
+		t->fill = NULL;
+		t->nslots = 0;
+		t->buckets = buckets;
+		t->nbuckets = DLOG_COMPACT_BUCKETS(m);
+
+		memset(buckets, 0, t->nbuckets * sizeof(*buckets));
+		for (i = 0; i < t->nbuckets; i++)
+			memset(buckets[i].idx, 0xff, sizeof(buckets[i].idx));
+	} else {
+		t->slots = slots;
+		t->fill = slots;
+		t->nslots = DLOG_TABLE_SLOTS(m);
+		t->buckets = NULL;
+		t->nbuckets = 0;
+
+		memset(slots, 0, t->nslots * sizeof(*slots));
+	}
+
+	t->lock = 0;
+	dlog_set_base(t, m, base);
+}
+
+/* Insert j*base for 0 <= j < m, one point at a time */
+static int dlog_fill(struct dlog_table *t)
+{
+	uint8_t key[ED25519_PACK_SIZE];
+	struct ed25519_pt p;
+	uint32_t j;
+
+	ed25519_copy(&p, &ed25519_neutral);
+	for (j = 0; j < t->m; j++) {
+		dlog_encode(key, &p);
+		if (!dlog_table_insert(t, key, j))
+			return 0;
+		ed25519_add_assign(&p, &t->base);
+	}
+
+	return 1;
+}
+
+void dlog_table_build(struct dlog_table *t, struct dlog_entry *slots,
+		      uint32_t m, const struct ed25519_pt *base)
+{
+	dlog_table_init(t, slots, NULL, m, base);
+	dlog_fill(t);
+}
+
+int dlog_table_build_compact(struct dlog_table *t,
+			     struct dlog_bucket *buckets,
+			     uint32_t m, const struct ed25519_pt *base)
+{
+	dlog_table_init(t, NULL, buckets, m, base);
+	return dlog_fill(t);
+}
+
+void dlog_table_attach(struct dlog_table *t, const struct dlog_entry *slots,
+		       uint32_t nslots, uint32_t m,
+		       const struct ed25519_pt *base)
+{
+	t->slots = slots;
+	t->fill = NULL;
+	t->nslots = nslots;
+	t->buckets = NULL;
+	t->nbuckets = 0;
+	t->lock = 0;
+	dlog_set_base(t, m, base);
+}
+
+int dlog_solve(const struct dlog_table *t, const struct ed25519_pt *target,
+	       uint64_t bound, uint64_t *v)
+{
+	const uint64_t steps = bound / t->m + 1;
+	uint8_t key[ED25519_PACK_SIZE];
+	struct ed25519_pt p;
+	uint64_t i;
+
+	ed25519_copy(&p, target);
+
+	/* After i giant steps, p = (v - i*m)*base */
+	for (i = 0; i < steps; i++) {
+		uint32_t j;
+
+		dlog_encode(key, &p);
+		j = dlog_table_find(t, key);
+
+		if (j) {
+			*v = i * t->m + j - 1;
+			return *v <= bound;
+		}
+
+		ed25519_add_assign(&p, &t->giant);
+	}
+
+	return 0;
+}
+
+int dlog_solve_near(const struct dlog_table *t,
+		    const struct ed25519_pt *target, uint64_t hint,
+		    uint64_t delta, uint64_t bound, uint64_t *v)
+{
+	const uint64_t above = (bound > hint) ? bound - hint : 0;
+	const uint64_t up_max = (delta < above) ? delta : above;
+	const uint64_t down_max = (delta < hint) ? delta : hint;
+	const uint64_t steps = ((up_max > down_max) ? up_max : down_max) /
+		t->m + 1;
+	uint8_t e[ED25519_EXPONENT_SIZE] = {0};
+	struct ed25519_pt walk[2];
+	uint8_t xs[2 * F25519_SIZE];
+	uint8_t ys[2 * F25519_SIZE];
+	uint8_t inv[2 * F25519_SIZE];
+	uint64_t i;
+
+	if (hint > bound)
+		return dlog_solve(t, target, bound, v);
+
+	/* walk[0] = target - hint*base = (v - hint)*base, walk[1] = -walk[0] */
+	for (i = 0; i < 8; i++)
+		e[i] = hint >> (i * 8);
+	ed25519_smult_bounded(&walk[0], &t->base, e, 64);
+	ed25519_cneg(&walk[0], 1);
+	ed25519_add(&walk[0], target, &walk[0]);
+	ed25519_copy(&walk[1], &walk[0]);
+	ed25519_cneg(&walk[1], 1);
+
+	/* Both walks take giant steps of -m. After i steps, walk[0] =
+	 * (v - hint - i*m)*base and walk[1] = (hint - v - i*m)*base, so a
+	 * table hit j gives v = hint + i*m + j or v = hint - i*m - j. The
+	 * two are normalized together with one inversion.
+	 */
+	for (i = 0; i < steps; i++) {
+		uint8_t key[ED25519_PACK_SIZE];
+		uint32_t j;
+
+		ed25519_unproject_batch(xs, ys, walk, 2, inv);
+
+		ed25519_pack(key, xs, ys);
+		j = dlog_table_find(t, key);
+		if (j && i * t->m + j - 1 <= up_max) {
+			*v = hint + i * t->m + j - 1;
+			return 1;
+		}
+
+		ed25519_pack(key, xs + F25519_SIZE, ys + F25519_SIZE);
+		j = dlog_table_find(t, key);
+		if (j && i * t->m + j - 1 <= down_max) {
+			*v = hint - (i * t->m + j - 1);
+			return 1;
+		}
+
+		ed25519_add_assign(&walk[0], &t->giant);
+		ed25519_add_assign(&walk[1], &t->giant);
+	}
+
+	return dlog_solve(t, target, bound, v);
+}
+
+int dlog_solve_signed(const struct dlog_table *t,
+		      const struct ed25519_pt *target, uint64_t bound,
+		      int64_t *v)
+{
+	const int64_t span = 2 * (int64_t)t->m - 1;
+	const uint64_t steps = (bound + t->m - 1) / span + 1;
+	struct ed25519_pt walk[2];
+	struct ed25519_pt step[2];
+	uint8_t xs[2 * F25519_SIZE];
+	uint8_t ys[2 * F25519_SIZE];
+	uint8_t inv[2 * F25519_SIZE];
+	uint64_t i;
+
+	/* step[0] = -span*base, step[1] = span*base */
+	ed25519_double(&step[0], &t->giant);
+	ed25519_add_assign(&step[0], &t->base);
+	ed25519_copy(&step[1], &step[0]);
+	ed25519_cneg(&step[1], 1);
+
+	ed25519_copy(&walk[0], target);
+	ed25519_copy(&walk[1], target);
+
+	/* The baby steps j*base cover |d| < m once signed, so giant steps
+	 * are span = 2m - 1 apart. After i steps, walk[0] = (v - i*span)*base
+	 * and walk[1] = (v + i*span)*base, and both are normalized with one
+	 * inversion.
+	 */
+	for (i = 0; i < steps; i++) {
+		int k;
+
+		ed25519_unproject_batch(xs, ys, walk, 2, inv);
+
+		for (k = 0; k < 2; k++) {
+			uint8_t key[ED25519_PACK_SIZE];
+			int64_t d, r;
+			uint32_t j;
+			int neg;
+
+			ed25519_pack(key, xs + k * F25519_SIZE,
+				     ys + k * F25519_SIZE);
+			j = dlog_table_find_signed(t, key, &neg);
+			if (!j)
+				continue;
+
+			d = neg ? -(int64_t)(j - 1) : (int64_t)(j - 1);
+			r = k ? d - (int64_t)i * span : d + (int64_t)i * span;
+
+			if (r >= -(int64_t)bound && r <= (int64_t)bound) {
+				*v = r;
+				return 1;
+			}
+		}
+
+		ed25519_add_assign(&walk[0], &step[0]);
+		ed25519_add_assign(&walk[1], &step[1]);
+	}
+
+	return 0;
+}
+
+unsigned int dlog_solve_batch(const struct dlog_table *t,
+			      const struct ed25519_pt *targets, unsigned int n,
+			      uint64_t bound, uint64_t *v, uint8_t *found,
+			      void *scratch)
+{
+	const uint64_t steps = bound / t->m + 1;
+	struct ed25519_pt *walk = scratch;
+	uint8_t *xs = (uint8_t *)(walk + n);
+	uint8_t *ys = xs + n * F25519_SIZE;
+	uint8_t *inv = ys + n * F25519_SIZE;
+	uint32_t *id = (uint32_t *)(inv + n * F25519_SIZE);
+	unsigned int active = n;
+	unsigned int solved = 0;
+	unsigned int a;
+	uint64_t i;
+
+	for (a = 0; a < n; a++) {
+		ed25519_copy(&walk[a], &targets[a]);
+		id[a] = a;
+		found[a] = 0;
+	}
+
+	/* After i giant steps, walk[a] = (v[id[a]] - i*m)*base. Walkers
+	 * that land in the table drop out, and the rest are packed down
+	 * so that every step normalizes one contiguous run.
+	 */
+	for (i = 0; i < steps && active; i++) {
+		unsigned int w = 0;
+
+		ed25519_unproject_batch(xs, ys, walk, active, inv);
+
+		for (a = 0; a < active; a++) {
+			uint8_t key[ED25519_PACK_SIZE];
+			uint32_t j;
+
+			ed25519_pack(key, xs + a * F25519_SIZE,
+				     ys + a * F25519_SIZE);
+			j = dlog_table_find(t, key);
+
+			if (j) {
+				const uint64_t r = i * t->m + j - 1;
+
+				if (r <= bound) {
+					v[id[a]] = r;
+					found[id[a]] = 1;
+					solved++;
+				}
+
+				continue;
+			}
+
+			if (w != a) {
+				ed25519_copy(&walk[w], &walk[a]);
+				id[w] = id[a];
+			}
+
+			ed25519_add_assign(&walk[w], &t->giant);
+			w++;
+		}
+
+		active = w;
+	}
+
+	return solved;
+}
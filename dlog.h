@@ -0,0 +1,186 @@
+/* Bounded discrete logarithms on the Edwards curve
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef DLOG_H_
+#define DLOG_H_
+
+#include <stdint.h>
+
+#include "ed25519.h"
+
+/* Recover m from m*G, given that 0 <= m <= bound, by baby-step
+ * giant-step. A table of the baby steps j*G, 0 <= j < m_baby, is built
+ * once. Each solve then walks target - i*m_baby*G until it lands in the
+ * table, taking at most bound/m_baby + 1 point additions. Choosing
+ * m_baby near sqrt(bound) balances table size against solve time.
+ *
+ * Table entries are keyed by the compressed point encoding
+ * (ed25519_pack()), and stored in an open-addressed hash table with
+ * linear probing. Storage is supplied by the caller, and should have
+ * room for DLOG_TABLE_SLOTS(m_baby) entries.
+ *
+ * A compact layout is also available, for tables too large to hold
+ * whole keys. It stores only a 32-bit fingerprint of y and j, in
+ * buckets of DLOG_BUCKET_WAYS slots placed by partial-key cuckoo
+ * hashing: a key lives in one of two buckets, the second derived from
+ * the first and the fingerprint alone, so entries can be moved without
+ * their keys. An entry is 8 bytes at 75% load, against 36 bytes at 50%
+ * load for the full layout. A fingerprint match is confirmed by
+ * recomputing j*base, so false positives cost time but never give a
+ * wrong answer. Storage should have room for DLOG_COMPACT_BUCKETS(m_baby)
+ * buckets.
+ *
+ * This works on public values only, and is not constant-time.
+ */
+#define DLOG_TABLE_SLOTS(m)  ((m) * 2)
+
+#define DLOG_BUCKET_WAYS  4
+#define DLOG_COMPACT_BUCKETS(m)  ((m) / 3 + 1)
+
+/* Identifies the slot hash (the low 32 bits of y, scaled onto the slot
+ * count), so that stored tables built with a different one are
+ * rejected. Change it if dlog_slot() changes.
+ */
+#define DLOG_HASH_ID  1
+
+struct dlog_entry {
+	uint8_t   key[ED25519_PACK_SIZE];
+
+	/* j + 1, or 0 if the slot is empty */
+	uint32_t  idx;
+};
+
+/* One cache-line half: fingerprints first, so a probe usually reads
+ * only them.
+ */
+struct dlog_bucket {
+	/* Bytes 4..7 of the key, or 0 if the slot is empty */
+	uint32_t  fp[DLOG_BUCKET_WAYS];
+
+	/* j, or all ones until a claimed slot is filled in */
+	uint32_t  idx[DLOG_BUCKET_WAYS];
+};
+
+struct dlog_table {
+	/* Full layout, or NULL. fill is the same storage, writable by
+	 * dlog_table_insert(), or NULL for an attached read-only table.
+	 */
+	const struct dlog_entry  *slots;
+	struct dlog_entry        *fill;
+	uint32_t                 nslots;
+
+	/* Compact layout, or NULL */
+	struct dlog_bucket  *buckets;
+	uint32_t            nbuckets;
+
+	uint32_t            m;
+
+	/* Serializes compact displacement chains during a build */
+	int                 lock;
+
+	/* base, for confirming compact matches */
+	struct ed25519_pt   base;
+
+	/* -m*G, the giant step */
+	struct ed25519_pt   giant;
+};
+
+/* Prepare an empty table of m baby steps for base, in the full layout
+ * if slots is given or the compact one if buckets is, and compute the
+ * giant step. Entries are then added with dlog_table_insert().
+ */
+void dlog_table_init(struct dlog_table *t, struct dlog_entry *slots,
+		     struct dlog_bucket *buckets, uint32_t m,
+		     const struct ed25519_pt *base);
+
+/* Add key = j*base, from any number of threads at once (but not while
+ * lookups are running). Returns 1 on success, or 0 if there was no room
+ * or the table is attached read-only.
+ */
+int dlog_table_insert(struct dlog_table *t, const uint8_t *key, uint32_t j);
+
+/* Fill the table with j*base for 0 <= j < m. slots must have room for
+ * DLOG_TABLE_SLOTS(m) entries.
+ */
+void dlog_table_build(struct dlog_table *t, struct dlog_entry *slots,
+		      uint32_t m, const struct ed25519_pt *base);
+
+/* Fill a compact table with j*base for 0 <= j < m. buckets must have
+ * room for DLOG_COMPACT_BUCKETS(m) entries. Returns 1 on success, or 0
+ * if an entry could not be placed (which is very unlikely at this
+ * load).
+ */
+int dlog_table_build_compact(struct dlog_table *t,
+			     struct dlog_bucket *buckets,
+			     uint32_t m, const struct ed25519_pt *base);
+
+/* Use slots that already hold a table of m baby steps for base, such
+ * as one mapped read-only from disk. Only the giant step is computed.
+ * The slots aren't trusted: lookups stop after nslots probes, and an
+ * entry claiming j >= m is treated as a miss.
+ */
+void dlog_table_attach(struct dlog_table *t, const struct dlog_entry *slots,
+		       uint32_t nslots, uint32_t m,
+		       const struct ed25519_pt *base);
+
+/* Look up a compressed point in either layout. Returns j + 1 if it is
+ * j*base, or 0 if it isn't in the table.
+ */
+uint32_t dlog_table_find(const struct dlog_table *t, const uint8_t *key);
+
+/* As dlog_table_find(), but also match the negation of j*base, setting
+ * *neg to 1 in that case and 0 otherwise. Bucket and probe positions
+ * depend on y alone, and (x, y) and (-x, y) are P and -P, so every table
+ * answers signed lookups with no extra storage.
+ */
+uint32_t dlog_table_find_signed(const struct dlog_table *t,
+				const uint8_t *key, int *neg);
+
+/* Solve target = v*base for 0 <= v <= bound. Returns 1 and sets *v if
+ * a solution was found, or 0 otherwise.
+ */
+int dlog_solve(const struct dlog_table *t, const struct ed25519_pt *target,
+	       uint64_t bound, uint64_t *v);
+
+/* Solve target = v*base for a signed v, -bound <= v <= bound (bound less
+ * than 2^62). Signed lookups let m baby steps cover 2m - 1 values, so
+ * this takes about bound/m steps: a centered range costs no more table
+ * than an unsigned one of half the width. Returns 1 and sets *v if a
+ * solution was found, or 0 otherwise.
+ */
+int dlog_solve_signed(const struct dlog_table *t,
+		      const struct ed25519_pt *target, uint64_t bound,
+		      int64_t *v);
+
+/* As dlog_solve(), but search outward from a hint first, such as the
+ * previous epoch's result: two walks, one up from the hint and one
+ * down, cover hint + d and hint - d together for d = 0, 1, ..., delta,
+ * taking |v - hint|/m + 1 steps.
+ * Only if v is further than delta from the hint does it fall back to
+ * the full search of [0, bound].
+ */
+int dlog_solve_near(const struct dlog_table *t,
+		    const struct ed25519_pt *target, uint64_t hint,
+		    uint64_t delta, uint64_t bound, uint64_t *v);
+
+/* Solve targets[i] = v[i]*base for n targets at once, advancing all
+ * giant-step walks together so that each step costs one inversion for
+ * the whole batch. found[i] is set to 1 if v[i] was found in [0, bound],
+ * and 0 otherwise. scratch must have room for DLOG_BATCH_SCRATCH(n)
+ * bytes, suitably aligned for a struct ed25519_pt. Returns the number
+ * of targets solved.
+ */
+#define DLOG_BATCH_SCRATCH(n) \
+	((n) * (sizeof(struct ed25519_pt) + 3 * F25519_SIZE + sizeof(uint32_t)))
+
+unsigned int dlog_solve_batch(const struct dlog_table *t,
+			      const struct ed25519_pt *targets, unsigned int n,
+			      uint64_t bound, uint64_t *v, uint8_t *found,
+			      void *scratch);
+
+/* Compressed encoding of a projective point */
+void dlog_encode(uint8_t *key, const struct ed25519_pt *p);
+
+#endif
@@ -5,6 +5,7 @@
  */
 
 #include "ed25519.h"
+#include "c25519.h"
 
 /* Base point is (numbers wrapped):
  *
@@ -69,6 +70,46 @@ void ed25519_unproject(uint8_t *x, uint8_t *y,
 	f25519_normalize(y);
 }
 
+void ed25519_unproject_batch(uint8_t *x, uint8_t *y,
+			     const struct ed25519_pt *p, unsigned int n,
+			     uint8_t *scratch)
+{
+	uint8_t inv[F25519_SIZE];
+	uint8_t zi[F25519_SIZE];
+	uint8_t t[F25519_SIZE];
+	unsigned int i;
+
+	if (!n)
+		return;
+
+	/* scratch[i] = z[0] z[1] ... z[i] */
+	f25519_copy(scratch, p[0].z);
+	for (i = 1; i < n; i++)
+		f25519_mul__distinct(scratch + i * F25519_SIZE,
+				     scratch + (i - 1) * F25519_SIZE, p[i].z);
+
+	f25519_inv__distinct(inv, scratch + (n - 1) * F25519_SIZE);
+
+	/* Peel off one point at a time. On entry to each iteration, inv
+	 * is the inverse of scratch[i].
+	 */
+	for (i = n - 1; i > 0; i--) {
+		f25519_mul__distinct(zi, inv, scratch + (i - 1) * F25519_SIZE);
+		f25519_mul__distinct(t, inv, p[i].z);
+		f25519_copy(inv, t);
+
+		f25519_mul__distinct(x + i * F25519_SIZE, p[i].x, zi);
+		f25519_mul__distinct(y + i * F25519_SIZE, p[i].y, zi);
+		f25519_normalize(x + i * F25519_SIZE);
+		f25519_normalize(y + i * F25519_SIZE);
+	}
+
+	f25519_mul__distinct(x, p[0].x, inv);
+	f25519_mul__distinct(y, p[0].y, inv);
+	f25519_normalize(x);
+	f25519_normalize(y);
+}
+
 /* Compress/uncompress points. We compress points by storing the x
  * coordinate and the parity of the y coordinate.
  *
@@ -228,6 +269,136 @@ void ed25519_add(struct ed25519_pt *r,
 	f25519_mul__distinct(r->z, f, g);
 }
 
+static void ed25519_affine_from_xy(struct ed25519_affine *r,
+				   const uint8_t *x, const uint8_t *y)
+{
+	uint8_t xy[F25519_SIZE];
+
+	f25519_add(r->yplusx, y, x);
+	f25519_sub(r->yminusx, y, x);
+	f25519_normalize(r->yplusx);
+	f25519_normalize(r->yminusx);
+
+	f25519_mul__distinct(xy, x, y);
+	f25519_mul__distinct(r->xy2d, xy, ed25519_k);
+	f25519_normalize(r->xy2d);
+}
+
+void ed25519_affine_prepare(struct ed25519_affine *r,
+			    const struct ed25519_pt *p)
+{
+	uint8_t x[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+
+	ed25519_unproject(x, y, p);
+	ed25519_affine_from_xy(r, x, y);
+}
+
+void ed25519_add_affine(struct ed25519_pt *r, const struct ed25519_pt *p,
+			const struct ed25519_affine *q)
+{
+	/* As ed25519_add(), with Z2 = 1 and the second point's terms
+	 * precomputed (madd-2008-hwcd-3).
+	 */
+	uint8_t a[F25519_SIZE];
+	uint8_t b[F25519_SIZE];
+	uint8_t c[F25519_SIZE];
+	uint8_t d[F25519_SIZE];
+	uint8_t e[F25519_SIZE];
+	uint8_t f[F25519_SIZE];
+	uint8_t g[F25519_SIZE];
+	uint8_t h[F25519_SIZE];
+
+	/* A = (Y1-X1)(Y2-X2) */
+	f25519_sub(c, p->y, p->x);
+	f25519_mul__distinct(a, c, q->yminusx);
+
+	/* B = (Y1+X1)(Y2+X2) */
+	f25519_add(c, p->y, p->x);
+	f25519_mul__distinct(b, c, q->yplusx);
+
+	/* C = T1 k T2 */
+	f25519_mul__distinct(c, p->t, q->xy2d);
+
+	/* D = 2 Z1 */
+	f25519_add(d, p->z, p->z);
+
+	/* E = B - A */
+	f25519_sub(e, b, a);
+
+	/* F = D - C */
+	f25519_sub(f, d, c);
+
+	/* G = D + C */
+	f25519_add(g, d, c);
+
+	/* H = B + A */
+	f25519_add(h, b, a);
+
+	/* X3 = E F */
+	f25519_mul__distinct(r->x, e, f);
+
+	/* Y3 = G H */
+	f25519_mul__distinct(r->y, g, h);
+
+	/* T3 = E H */
+	f25519_mul__distinct(r->t, e, h);
+
+	/* Z3 = F G */
+	f25519_mul__distinct(r->z, f, g);
+}
+
+void ed25519_affine_table(struct ed25519_affine *table,
+			  const struct ed25519_pt *p, unsigned int n)
+{
+	struct ed25519_affine step;
+	struct ed25519_pt q;
+	unsigned int j;
+
+	ed25519_affine_prepare(&step, p);
+	ed25519_copy(&q, &ed25519_neutral);
+
+	for (j = 0; j < n; j++) {
+		ed25519_affine_prepare(&table[j], &q);
+		ed25519_add_affine(&q, &q, &step);
+	}
+}
+
+void ed25519_affine_lookup(struct ed25519_affine *r,
+			   const struct ed25519_affine *table,
+			   unsigned int n, unsigned int idx)
+{
+	unsigned int k;
+
+	/* The neutral point is (y + x, y - x, 2dxy) = (1, 1, 0) */
+	f25519_load(r->yplusx, 1);
+	f25519_load(r->yminusx, 1);
+	f25519_load(r->xy2d, 0);
+
+	for (k = 0; k < n; k++) {
+		const uint32_t diff = k ^ idx;
+		const uint8_t eq = (diff - 1) >> 31 & ~(diff >> 31);
+
+		f25519_select(r->yplusx, r->yplusx, table[k].yplusx, eq);
+		f25519_select(r->yminusx, r->yminusx, table[k].yminusx, eq);
+		f25519_select(r->xy2d, r->xy2d, table[k].xy2d, eq);
+	}
+}
+
+void ed25519_affine_cneg(struct ed25519_affine *r, uint8_t condition)
+{
+	/* -(x, y) = (-x, y): swap y + x with y - x, and negate 2dxy */
+	uint8_t tmp[F25519_SIZE];
+	uint8_t neg[F25519_SIZE];
+
+	f25519_copy(tmp, r->yplusx);
+	f25519_select(r->yplusx, r->yplusx, r->yminusx, condition);
+	f25519_select(r->yminusx, r->yminusx, tmp, condition);
+
+	f25519_neg(neg, r->xy2d);
+	f25519_select(r->xy2d, r->xy2d, neg, condition);
+}
+
 void ed25519_double(struct ed25519_pt *r, const struct ed25519_pt *p)
 {
 	/* Explicit formulas database: dbl-2008-hwcd
@@ -295,26 +466,396 @@ void ed25519_double(struct ed25519_pt *r, const struct ed25519_pt *p)
 	f25519_mul__distinct(r->z, f, g);
 }
 
+void ed25519_cswap(struct ed25519_pt *a, struct ed25519_pt *b,
+		   uint8_t condition)
+{
+	const uint32_t mask = -(uint32_t)condition;
+	uint8_t *pa = (uint8_t *)a;
+	uint8_t *pb = (uint8_t *)b;
+	unsigned int i;
+
+	/* The struct is a whole number of words. Going through memcpy()
+	 * keeps this safe for unaligned points, and compiles down to
+	 * plain word loads and stores.
+	 */
+	for (i = 0; i < sizeof(*a); i += sizeof(uint32_t)) {
+		uint32_t wa, wb, d;
+
+		memcpy(&wa, pa + i, sizeof(wa));
+		memcpy(&wb, pb + i, sizeof(wb));
+		d = mask & (wa ^ wb);
+		wa ^= d;
+		wb ^= d;
+		memcpy(pa + i, &wa, sizeof(wa));
+		memcpy(pb + i, &wb, sizeof(wb));
+	}
+}
+
 void ed25519_smult(struct ed25519_pt *r_out, const struct ed25519_pt *p,
 		   const uint8_t *e)
+{
+	ed25519_smult_bounded(r_out, p, e, ED25519_EXPONENT_SIZE * 8);
+}
+
+void ed25519_smult_bounded(struct ed25519_pt *r_out,
+			   const struct ed25519_pt *p,
+			   const uint8_t *e, unsigned int nbits)
 {
 	struct ed25519_pt r;
 	int i;
 
 	ed25519_copy(&r, &ed25519_neutral);
 
-	for (i = 255; i >= 0; i--) {
+	for (i = nbits - 1; i >= 0; i--) {
 		const uint8_t bit = (e[i >> 3] >> (i & 7)) & 1;
 		struct ed25519_pt s;
 
-		ed25519_double(&r, &r);
+		ed25519_double_assign(&r);
 		ed25519_add(&s, &r, p);
-
-		f25519_select(r.x, r.x, s.x, bit);
-		f25519_select(r.y, r.y, s.y, bit);
-		f25519_select(r.z, r.z, s.z, bit);
-		f25519_select(r.t, r.t, s.t, bit);
+		ed25519_cswap(&r, &s, bit);
 	}
 
 	ed25519_copy(r_out, &r);
 }
+
+void ed25519_prepare_scalar(struct ed25519_scalar_prep *s,
+			    const uint8_t *e)
+{
+	int8_t carry = 0;
+	int i;
+
+	/* Split into nibbles, then move each nibble from [0, 16) to
+	 * [-8, 8), carrying into the next.
+	 */
+	for (i = 0; i < ED25519_EXPONENT_SIZE; i++) {
+		s->d[i * 2] = e[i] & 15;
+		s->d[i * 2 + 1] = e[i] >> 4;
+	}
+
+	for (i = 0; i + 1 < ED25519_PREP_DIGITS; i++) {
+		s->d[i] += carry;
+		carry = (s->d[i] + 8) >> 4;
+		s->d[i] -= carry * 16;
+	}
+
+	s->d[i] = carry;
+}
+
+void ed25519_cneg(struct ed25519_pt *p, uint8_t condition)
+{
+	uint8_t nx[F25519_SIZE];
+	uint8_t nt[F25519_SIZE];
+
+	/* -(x, y) = (-x, y) */
+	f25519_neg(nx, p->x);
+	f25519_neg(nt, p->t);
+	f25519_select(p->x, p->x, nx, condition);
+	f25519_select(p->t, p->t, nt, condition);
+}
+
+/* Conditional move: dst = src if condition == 1, unchanged if 0 */
+static void ed25519_cmov(struct ed25519_pt *dst, const struct ed25519_pt *src,
+			 uint8_t condition)
+{
+	f25519_select(dst->x, dst->x, src->x, condition);
+	f25519_select(dst->y, dst->y, src->y, condition);
+	f25519_select(dst->t, dst->t, src->t, condition);
+	f25519_select(dst->z, dst->z, src->z, condition);
+}
+
+/* Load d * P from the table of 1P..8P, by scanning every entry */
+static void ed25519_prep_lookup(struct ed25519_pt *r,
+				const struct ed25519_pt *table, int8_t d)
+{
+	const uint8_t neg = ((uint8_t)d) >> 7;
+	const uint8_t mag = (d ^ -neg) + neg;
+	int k;
+
+	ed25519_copy(r, &ed25519_neutral);
+
+	for (k = 1; k <= 8; k++) {
+		const uint8_t diff = mag ^ k;
+		const uint8_t eq = ((uint8_t)(diff - 1)) >> 7;
+
+		ed25519_cmov(r, &table[k - 1], eq);
+	}
+
+	ed25519_cneg(r, neg);
+}
+
+void ed25519_smult_prepared(struct ed25519_pt *r, const struct ed25519_pt *p,
+			    const struct ed25519_scalar_prep *s)
+{
+	struct ed25519_pt table[8];
+	struct ed25519_pt q;
+	int i;
+
+	ed25519_copy(&table[0], p);
+	for (i = 1; i < 8; i++)
+		ed25519_add(&table[i], &table[i - 1], p);
+
+	ed25519_prep_lookup(r, table, s->d[ED25519_PREP_DIGITS - 1]);
+
+	for (i = ED25519_PREP_DIGITS - 2; i >= 0; i--) {
+		ed25519_double_assign(r);
+		ed25519_double_assign(r);
+		ed25519_double_assign(r);
+		ed25519_double_assign(r);
+
+		ed25519_prep_lookup(&q, table, s->d[i]);
+		ed25519_add_assign(r, &q);
+	}
+}
+
+/* Montgomery form conversion.
+ *
+ * c = sqrt(-486664) =
+ *     685347521949756158157935727119762464248
+ *     2790079785650197046958215289687604742
+ */
+static const uint8_t ed25519_mont_c[F25519_SIZE] = {
+	0x06, 0x7e, 0x45, 0xff, 0xaa, 0x04, 0x6e, 0xcc,
+	0x82, 0x1a, 0x7d, 0x4b, 0xd1, 0xd3, 0xa1, 0xc5,
+	0x7e, 0x4f, 0xfc, 0x03, 0xdc, 0x08, 0x7b, 0xd2,
+	0xbb, 0x06, 0xa0, 0x60, 0xf4, 0xed, 0x26, 0x0f
+};
+
+void ed25519_to_montgomery(uint8_t *u, const struct ed25519_pt *p)
+{
+	uint8_t a[F25519_SIZE];
+	uint8_t b[F25519_SIZE];
+
+	/* u = (1+y)/(1-y) = (Z+Y)/(Z-Y) */
+	f25519_sub(a, p->z, p->y);
+	f25519_inv__distinct(b, a);
+	f25519_add(a, p->z, p->y);
+	f25519_mul__distinct(u, a, b);
+	f25519_normalize(u);
+}
+
+void ed25519_montgomery_y(uint8_t *y, const uint8_t *u)
+{
+	uint8_t a[F25519_SIZE];
+	uint8_t b[F25519_SIZE];
+
+	/* y = (u-1)/(u+1) */
+	f25519_add(a, u, f25519_one);
+	f25519_inv__distinct(b, a);
+	f25519_sub(a, u, f25519_one);
+	f25519_mul__distinct(y, a, b);
+	f25519_normalize(y);
+}
+
+void ed25519_mont_prepare(struct ed25519_mont_base *b,
+			  const struct ed25519_pt *p)
+{
+	uint8_t zpy[F25519_SIZE];
+	uint8_t a[F25519_SIZE];
+	uint8_t d[F25519_SIZE];
+	uint8_t di[F25519_SIZE];
+
+	/* With a common denominator (Z-Y)X:
+	 *
+	 *     u = (Z+Y)X / ((Z-Y)X)
+	 *     v = c(Z+Y)Z / ((Z-Y)X)
+	 */
+	f25519_sub(a, p->z, p->y);
+	f25519_mul__distinct(d, a, p->x);
+	f25519_inv__distinct(di, d);
+
+	f25519_add(zpy, p->z, p->y);
+	f25519_mul__distinct(a, zpy, p->x);
+	f25519_mul__distinct(b->u, a, di);
+	f25519_normalize(b->u);
+
+	f25519_mul__distinct(a, zpy, p->z);
+	f25519_mul__distinct(d, a, ed25519_mont_c);
+	f25519_mul__distinct(b->v, d, di);
+	f25519_normalize(b->v);
+}
+
+void ed25519_smult_mont(struct ed25519_pt *r,
+			const struct ed25519_mont_base *b, const uint8_t *e)
+{
+	uint8_t x1[F25519_SIZE];
+	uint8_t z1[F25519_SIZE];
+	uint8_t x2[F25519_SIZE];
+	uint8_t z2[F25519_SIZE];
+	uint8_t v1[F25519_SIZE];
+	uint8_t v2[F25519_SIZE];
+	uint8_t v3[F25519_SIZE];
+	uint8_t v4[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+
+	/* (x1:z1) = eP, (x2:z2) = (e+1)P */
+	c25519_smult_xz(x1, z1, x2, z2, b->u, e);
+
+	/* Okeya-Sakurai Y-coordinate recovery, for B = 1, A = 486662:
+	 *
+	 * source 2001 Okeya--Sakurai, "Efficient elliptic curve
+	 *     cryptosystems from a scalar multiplication algorithm with
+	 *     recovery of the y-coordinate on a Montgomery-form elliptic
+	 *     curve", CHES 2001, Algorithm 1
+	 * compute Y = ((xP Z1 + X1 + 2A Z1)(xP X1 + Z1) - 2A Z1^2) Z2
+	 *             - (X1 - xP Z1)^2 X2
+	 * compute W = 2 yP Z1 Z2
+	 * compute X = W X1
+	 * compute Z = W Z1
+	 */
+	f25519_mul__distinct(v1, b->u, z1);
+	f25519_add(v2, x1, v1);
+	f25519_sub(v3, x1, v1);
+	f25519_mul__distinct(v4, v3, v3);
+	f25519_mul__distinct(v3, v4, x2);
+	f25519_mul_c(v1, z1, 973324);
+	f25519_add(v2, v2, v1);
+	f25519_mul__distinct(v4, b->u, x1);
+	f25519_add(v4, v4, z1);
+	f25519_mul__distinct(y, v2, v4);
+	f25519_mul__distinct(v2, v1, z1);
+	f25519_sub(y, y, v2);
+	f25519_mul__distinct(v2, y, z2);
+	f25519_sub(y, v2, v3);
+
+	f25519_add(v1, b->v, b->v);
+	f25519_mul__distinct(v2, v1, z1);
+	f25519_mul__distinct(v1, v2, z2);
+	f25519_mul__distinct(x2, v1, x1);
+	f25519_mul__distinct(z2, v1, z1);
+
+	/* Back to Edwards form, still without inverting. Affine
+	 * coordinates are x = cX/Y and y = (X-Z)/(X+Z). Writing these as
+	 * a/b and c/d, the extended point is (ad : cb : ac : bd).
+	 */
+	f25519_mul__distinct(v1, ed25519_mont_c, x2);	/* a */
+	f25519_sub(v3, x2, z2);				/* c */
+	f25519_add(v4, x2, z2);				/* d */
+
+	f25519_mul__distinct(r->x, v1, v4);
+	f25519_mul__distinct(r->y, v3, y);
+	f25519_mul__distinct(r->t, v1, v3);
+	f25519_mul__distinct(r->z, y, v4);
+}
+
+void ed25519_fixed_prepare(struct ed25519_fixed_table *t,
+			   const struct ed25519_pt *p)
+{
+	struct ed25519_pt pts[ED25519_FIXED_BATCH_ROWS * 8];
+	uint8_t xs[ED25519_FIXED_BATCH_ROWS * 8 * F25519_SIZE];
+	uint8_t ys[ED25519_FIXED_BATCH_ROWS * 8 * F25519_SIZE];
+	uint8_t scratch[ED25519_FIXED_BATCH_ROWS * 8 * F25519_SIZE];
+	struct ed25519_pt q;
+	int i, k;
+
+	/* q = 16^i*P. Rows are normalized a batch at a time, with one
+	 * inversion per batch.
+	 */
+	ed25519_copy(&q, p);
+
+	for (i = 0; i < ED25519_PREP_DIGITS; i += ED25519_FIXED_BATCH_ROWS) {
+		const int rows = (ED25519_PREP_DIGITS - i <
+				  ED25519_FIXED_BATCH_ROWS) ?
+			ED25519_PREP_DIGITS - i : ED25519_FIXED_BATCH_ROWS;
+		int j;
+
+		for (j = 0; j < rows; j++) {
+			struct ed25519_pt *row = pts + j * 8;
+
+			ed25519_copy(&row[0], &q);
+			for (k = 1; k < 8; k++)
+				ed25519_add(&row[k], &row[k - 1], &q);
+
+			ed25519_double(&q, &row[7]);
+		}
+
+		ed25519_unproject_batch(xs, ys, pts, rows * 8, scratch);
+
+		for (j = 0; j < rows * 8; j++)
+			ed25519_affine_from_xy(&t->row[i + j / 8][j % 8],
+					       xs + j * F25519_SIZE,
+					       ys + j * F25519_SIZE);
+	}
+}
+
+void ed25519_smult_fixed(struct ed25519_pt *r,
+			 const struct ed25519_fixed_table *t,
+			 const struct ed25519_scalar_prep *s)
+{
+	struct ed25519_affine a;
+	int i;
+
+	ed25519_copy(r, &ed25519_neutral);
+
+	for (i = 0; i < ED25519_PREP_DIGITS; i++) {
+		const uint8_t neg = ((uint8_t)s->d[i]) >> 7;
+		const uint8_t mag = (s->d[i] ^ -neg) + neg;
+
+		/* mag = 0 wraps to an index past the row: the neutral point */
+		ed25519_affine_lookup(&a, t->row[i], 8, mag - 1U);
+		ed25519_affine_cneg(&a, neg);
+		ed25519_add_affine(r, r, &a);
+	}
+}
+
+void ed25519_smult_batch(struct ed25519_pt *const *out,
+			 const struct ed25519_pt *const *bases,
+			 const uint8_t *const *scalars, unsigned int n)
+{
+	struct ed25519_pt pts[ED25519_BATCH_LANES * 8];
+	uint8_t xs[ED25519_BATCH_LANES * 8 * F25519_SIZE];
+	uint8_t ys[ED25519_BATCH_LANES * 8 * F25519_SIZE];
+	uint8_t scratch[ED25519_BATCH_LANES * 8 * F25519_SIZE];
+	struct ed25519_affine table[ED25519_BATCH_LANES][8];
+	struct ed25519_scalar_prep prep[ED25519_BATCH_LANES];
+	unsigned int k;
+
+	for (k = 0; k < n; k += ED25519_BATCH_LANES) {
+		const unsigned int lanes = (n - k < ED25519_BATCH_LANES) ?
+			n - k : ED25519_BATCH_LANES;
+		struct ed25519_affine a;
+		unsigned int j;
+		int i;
+
+		/* Tables of 1P..8P for every lane, normalized together
+		 * with a single inversion.
+		 */
+		for (j = 0; j < lanes; j++) {
+			struct ed25519_pt *row = pts + j * 8;
+
+			ed25519_prepare_scalar(&prep[j], scalars[k + j]);
+
+			ed25519_copy(&row[0], bases[k + j]);
+			for (i = 1; i < 8; i++)
+				ed25519_add(&row[i], &row[i - 1], bases[k + j]);
+		}
+
+		ed25519_unproject_batch(xs, ys, pts, lanes * 8, scratch);
+
+		for (j = 0; j < lanes * 8; j++)
+			ed25519_affine_from_xy(&table[j / 8][j % 8],
+					       xs + j * F25519_SIZE,
+					       ys + j * F25519_SIZE);
+
+		for (j = 0; j < lanes; j++)
+			ed25519_copy(out[k + j], &ed25519_neutral);
+
+		for (i = ED25519_PREP_DIGITS - 1; i >= 0; i--) {
+			for (j = 0; j < lanes; j++) {
+				struct ed25519_pt *r = out[k + j];
+				const int8_t d = prep[j].d[i];
+				const uint8_t neg = ((uint8_t)d) >> 7;
+				const uint8_t mag = (d ^ -neg) + neg;
+
+				ed25519_double_assign(r);
+				ed25519_double_assign(r);
+				ed25519_double_assign(r);
+				ed25519_double_assign(r);
+
+				ed25519_affine_lookup(&a, table[j], 8,
+						      mag - 1U);
+				ed25519_affine_cneg(&a, neg);
+				ed25519_add_affine(r, r, &a);
+			}
+		}
+	}
+}
@@ -46,6 +46,15 @@ void ed25519_project(struct ed25519_pt *p,
 void ed25519_unproject(uint8_t *x, uint8_t *y,
 		       const struct ed25519_pt *p);
 
+/* Convert n points to affine coordinates with a single inversion
+ * (Montgomery's trick), at the cost of three extra multiplications per
+ * point. x and y receive n consecutive field elements each, and scratch
+ * must have room for n field elements. No point may have Z = 0.
+ */
+void ed25519_unproject_batch(uint8_t *x, uint8_t *y,
+			     const struct ed25519_pt *p, unsigned int n,
+			     uint8_t *scratch);
+
 /* Compress/uncompress points. try_unpack() will check that the
  * compressed point is on the curve, returning 1 if the unpacked point
  * is valid, and 0 otherwise.
@@ -73,10 +82,172 @@ static inline void ed25519_copy(struct ed25519_pt *dst,
 	memcpy(dst, src, sizeof(*dst));
 }
 
+/* Add and double. All inputs are read before the result is written, so
+ * the output may alias any of the inputs.
+ */
 void ed25519_add(struct ed25519_pt *r,
 		 const struct ed25519_pt *a, const struct ed25519_pt *b);
 void ed25519_double(struct ed25519_pt *r, const struct ed25519_pt *a);
+
+/* In-place variants for accumulation loops: acc += p, acc = 2acc */
+static inline void ed25519_add_assign(struct ed25519_pt *acc,
+				      const struct ed25519_pt *p)
+{
+	ed25519_add(acc, acc, p);
+}
+
+static inline void ed25519_double_assign(struct ed25519_pt *acc)
+{
+	ed25519_double(acc, acc);
+}
+
+/* An affine point, precomputed for addition: (y + x, y - x, 2dxy). Adding
+ * one to a projective point (mixed addition) takes 7 multiplications
+ * rather than 9, which pays off for points that are added many times.
+ */
+struct ed25519_affine {
+	uint8_t  yplusx[F25519_SIZE];
+	uint8_t  yminusx[F25519_SIZE];
+	uint8_t  xy2d[F25519_SIZE];
+};
+
+void ed25519_affine_prepare(struct ed25519_affine *r,
+			    const struct ed25519_pt *p);
+
+/* r = p + q. r may alias p. */
+void ed25519_add_affine(struct ed25519_pt *r, const struct ed25519_pt *p,
+			const struct ed25519_affine *q);
+
+/* Fill table[j] with j*p for 0 <= j < n, such as the encodings of all
+ * small plaintexts.
+ */
+void ed25519_affine_table(struct ed25519_affine *table,
+			  const struct ed25519_pt *p, unsigned int n);
+
+/* r = table[idx], or the neutral point if idx >= n. Every entry is read
+ * and selected with a mask, so the time and memory access pattern
+ * don't depend on idx.
+ */
+void ed25519_affine_lookup(struct ed25519_affine *r,
+			   const struct ed25519_affine *table,
+			   unsigned int n, unsigned int idx);
+
+/* r = -r if condition == 1, unchanged if 0, in constant time */
+void ed25519_affine_cneg(struct ed25519_affine *r, uint8_t condition);
+
+/* Conditional negation: p = -p if condition == 1, unchanged if 0. Runs
+ * in constant time.
+ */
+void ed25519_cneg(struct ed25519_pt *p, uint8_t condition);
+
+/* Conditional swap. If condition == 1, the contents of a and b are
+ * exchanged. If condition == 0, nothing changes. Any other value results
+ * in undefined behaviour. Runs in constant time, a word at a time.
+ */
+void ed25519_cswap(struct ed25519_pt *a, struct ed25519_pt *b,
+		   uint8_t condition);
+
 void ed25519_smult(struct ed25519_pt *r, const struct ed25519_pt *a,
 		   const uint8_t *e);
 
+/* Compute n independent scalar multiplications, out[i] = scalars[i] *
+ * bases[i], as ed25519_smult() would. Scalars are recoded into signed
+ * radix-16 digits (see below), and each base gets a table of 1P..8P.
+ * The tables of up to ED25519_BATCH_LANES multiplications are
+ * normalized with a single inversion, so that each digit costs four
+ * doublings and one constant-time mixed addition, instead of one full
+ * addition per bit. The tables take about 2.6 KB of stack per lane;
+ * lower ED25519_BATCH_LANES for small stacks.
+ */
+#ifndef ED25519_BATCH_LANES
+#define ED25519_BATCH_LANES  4
+#endif
+
+void ed25519_smult_batch(struct ed25519_pt *const *out,
+			 const struct ed25519_pt *const *bases,
+			 const uint8_t *const *scalars, unsigned int n);
+
+/* A scalar recoded once into signed radix-16 digits, for reuse across
+ * many multiplications by the same exponent (e.g. a per-epoch r):
+ *
+ *     e = sum(d[i] * 16^i), -8 <= d[i] < 8 (the top digit is 0 or 1)
+ *
+ * ed25519_smult_prepared() then needs a table of 1P..8P and one
+ * addition per digit, instead of one addition per bit. Table lookups
+ * and digit signs are handled in constant time.
+ */
+#define ED25519_PREP_DIGITS  (ED25519_EXPONENT_SIZE * 2 + 1)
+
+struct ed25519_scalar_prep {
+	int8_t  d[ED25519_PREP_DIGITS];
+};
+
+void ed25519_prepare_scalar(struct ed25519_scalar_prep *s,
+			    const uint8_t *e);
+void ed25519_smult_prepared(struct ed25519_pt *r, const struct ed25519_pt *p,
+			    const struct ed25519_scalar_prep *s);
+
+/* Fixed-base table for a point that is multiplied by many prepared
+ * scalars, such as a long-lived public key: row i holds k*16^i*P for
+ * k = 1..8, in cached affine form. ed25519_smult_fixed() then needs no
+ * doublings, only one constant-time row lookup and mixed addition per
+ * digit. A table is about 49 KB, and takes about as long to build as a
+ * few ordinary multiplications. Building normalizes
+ * ED25519_FIXED_BATCH_ROWS rows with each inversion, using about 14 KB
+ * of stack at the default of 8; lower it for small stacks.
+ */
+#ifndef ED25519_FIXED_BATCH_ROWS
+#define ED25519_FIXED_BATCH_ROWS  8
+#endif
+
+struct ed25519_fixed_table {
+	struct ed25519_affine  row[ED25519_PREP_DIGITS][8];
+};
+
+void ed25519_fixed_prepare(struct ed25519_fixed_table *t,
+			   const struct ed25519_pt *p);
+void ed25519_smult_fixed(struct ed25519_pt *r,
+			 const struct ed25519_fixed_table *t,
+			 const struct ed25519_scalar_prep *s);
+
+/* Scalar multiply by an exponent known to be less than 2^nbits. Only
+ * the low nbits bits of e are examined, so the running time depends on
+ * the (public) bound, but not on the value of e. nbits must be no more
+ * than 256.
+ */
+void ed25519_smult_bounded(struct ed25519_pt *r, const struct ed25519_pt *a,
+			   const uint8_t *e, unsigned int nbits);
+
+/* Conversion to and from Curve25519 (Montgomery form). The birational
+ * maps are:
+ *
+ *     u = (1+y)/(1-y)        y = (u-1)/(u+1)
+ *     v = c u/x              x = c u/v
+ *
+ * Where c = sqrt(-486664). The neutral point and the point of order two
+ * have no image, and should not be passed in.
+ */
+void ed25519_to_montgomery(uint8_t *u, const struct ed25519_pt *p);
+void ed25519_montgomery_y(uint8_t *y, const uint8_t *u);
+
+/* A base point converted to affine Montgomery coordinates, for
+ * multiplication on the X-only ladder. Preparing the base costs one
+ * inversion; every multiplication by it afterwards costs none.
+ */
+struct ed25519_mont_base {
+	uint8_t  u[F25519_SIZE];
+	uint8_t  v[F25519_SIZE];
+};
+
+void ed25519_mont_prepare(struct ed25519_mont_base *b,
+			  const struct ed25519_pt *p);
+
+/* Scalar multiply using c25519_smult_xz(), then recover the
+ * Y-coordinate and map back to (projective) Edwards form. Gives the
+ * same point as ed25519_smult() for exponents with bit 255 clear and
+ * bit 254 set, which c25519_prepare() guarantees.
+ */
+void ed25519_smult_mont(struct ed25519_pt *r,
+			const struct ed25519_mont_base *b, const uint8_t *e);
+
 #endif
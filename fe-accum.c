@@ -0,0 +1,166 @@
+/* Streaming ciphertext accumulator
+ *
+ * This file is in the public domain.
+ */
+
+#include "fe-accum.h"
+
+void fe_accum_init(struct fe_accum *a, uint8_t *bitmap, uint32_t n)
+{
+	ed25519_copy(&a->sum, &ed25519_neutral);
+	a->seen = bitmap;
+	a->n = n;
+	a->count = 0;
+
+	memset(bitmap, 0, FE_ACCUM_BITMAP_SIZE(n));
+}
+
+int fe_accum_has(const struct fe_accum *a, uint32_t id)
+{
+	if (id >= a->n)
+		return 0;
+
+	return (a->seen[id >> 3] >> (id & 7)) & 1;
+}
+
+int fe_accum_absorb(struct fe_accum *a, uint32_t id,
+		    const struct ed25519_pt *ct)
+{
+	if (id >= a->n || fe_accum_has(a, id))
+		return 0;
+
+	a->seen[id >> 3] |= 1 << (id & 7);
+	a->count++;
+	ed25519_add_assign(&a->sum, ct);
+
+	return 1;
+}
+
+int fe_accum_absorb_range(struct fe_accum *a, uint32_t first, uint32_t n,
+			  const struct ed25519_pt *sum)
+{
+	uint32_t i;
+
+	if (first > a->n || n > a->n - first)
+		return 0;
+
+	for (i = first; i < first + n; i++)
+		if (fe_accum_has(a, i))
+			return 0;
+
+	for (i = first; i < first + n; i++)
+		a->seen[i >> 3] |= 1 << (i & 7);
+
+	a->count += n;
+	ed25519_add_assign(&a->sum, sum);
+
+	return 1;
+}
+
+int fe_accum_complete(const struct fe_accum *a, const uint8_t *expected)
+{
+	const uint32_t full = a->n >> 3;
+	const uint8_t tail = (1 << (a->n & 7)) - 1;
+	uint32_t i;
+
+	if (!expected)
+		return a->count == a->n;
+
+	for (i = 0; i < full; i++)
+		if (a->seen[i] != expected[i])
+			return 0;
+
+	return !tail || !((a->seen[full] ^ expected[full]) & tail);
+}
+
+int fe_accum_finalize(const struct fe_accum *a, const uint8_t *expected,
+		      struct ed25519_pt *sum)
+{
+	if (!fe_accum_complete(a, expected))
+		return 0;
+
+	ed25519_copy(sum, &a->sum);
+	return 1;
+}
+
+int fe_accum_merge(struct fe_accum *a, const struct fe_accum *b)
+{
+	const uint32_t nbytes = FE_ACCUM_BITMAP_SIZE(a->n);
+	uint32_t i;
+
+	if (a->n != b->n)
+		return 0;
+
+	for (i = 0; i < nbytes; i++)
+		if (a->seen[i] & b->seen[i])
+			return 0;
+
+	for (i = 0; i < nbytes; i++)
+		a->seen[i] |= b->seen[i];
+
+	a->count += b->count;
+	ed25519_add_assign(&a->sum, &b->sum);
+
+	return 1;
+}
+
+void fe_accum_pack(const struct fe_accum *a, uint8_t *buf)
+{
+	uint8_t x[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+
+	ed25519_unproject(x, y, &a->sum);
+	ed25519_pack(buf, x, y);
+	buf += ED25519_PACK_SIZE;
+
+	buf[0] = a->count;
+	buf[1] = a->count >> 8;
+	buf[2] = a->count >> 16;
+	buf[3] = a->count >> 24;
+	buf += 4;
+
+	memcpy(buf, a->seen, FE_ACCUM_BITMAP_SIZE(a->n));
+}
+
+static unsigned int popcount8(uint8_t v)
+{
+	v = (v & 0x55) + ((v >> 1) & 0x55);
+	v = (v & 0x33) + ((v >> 2) & 0x33);
+	return (v & 0x0f) + (v >> 4);
+}
+
+int fe_accum_unpack(struct fe_accum *a, uint8_t *bitmap, uint32_t n,
+		    const uint8_t *buf)
+{
+	const uint32_t nbytes = FE_ACCUM_BITMAP_SIZE(n);
+	const uint8_t *seen = buf + ED25519_PACK_SIZE + 4;
+	uint8_t x[F25519_SIZE];
+	uint8_t y[F25519_SIZE];
+	uint32_t count, bits = 0;
+	uint32_t i;
+
+	if (!ed25519_try_unpack(x, y, buf))
+		return 0;
+
+	count = ((uint32_t)buf[ED25519_PACK_SIZE]) |
+		(((uint32_t)buf[ED25519_PACK_SIZE + 1]) << 8) |
+		(((uint32_t)buf[ED25519_PACK_SIZE + 2]) << 16) |
+		(((uint32_t)buf[ED25519_PACK_SIZE + 3]) << 24);
+
+	if ((n & 7) && (seen[nbytes - 1] >> (n & 7)))
+		return 0;
+
+	for (i = 0; i < nbytes; i++)
+		bits += popcount8(seen[i]);
+
+	if (bits != count)
+		return 0;
+
+	ed25519_project(&a->sum, x, y);
+	memcpy(bitmap, seen, nbytes);
+	a->seen = bitmap;
+	a->n = n;
+	a->count = count;
+
+	return 1;
+}
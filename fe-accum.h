@@ -0,0 +1,101 @@
+/* Streaming ciphertext accumulator
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef FE_ACCUM_H_
+#define FE_ACCUM_H_
+
+#include <stdint.h>
+
+#include "ed25519.h"
+
+/* Folds ciphertexts into their sum as they arrive, so the aggregator
+ * needs constant memory (one point, plus one bit per user) rather than
+ * a copy of every ciphertext. Users are numbered 0 .. n-1, and each
+ * one's ciphertext is absorbed at most once; the bitmap of contributors
+ * decides when the sum is ready for decryption.
+ *
+ * The bitmap is supplied by the caller, and should have room for
+ * FE_ACCUM_BITMAP_SIZE(n) bytes.
+ */
+#define FE_ACCUM_BITMAP_SIZE(n)  (((n) + 7) / 8)
+
+struct fe_accum {
+	struct ed25519_pt  sum;
+	uint8_t            *seen;
+	uint32_t           n;
+	uint32_t           count;
+};
+
+void fe_accum_init(struct fe_accum *a, uint8_t *bitmap, uint32_t n);
+
+/* Add user id's ciphertext. Returns 1 if it was added, or 0 if id is
+ * out of range or has already contributed.
+ */
+int fe_accum_absorb(struct fe_accum *a, uint32_t id,
+		    const struct ed25519_pt *ct);
+
+/* Add the ciphertexts of users first .. first+n-1 at once, given their
+ * sum, e.g. from fe_point_sum_parallel(). Returns 1 if they were added,
+ * or 0 (leaving a unchanged) if the range is out of bounds or any of
+ * them has already contributed.
+ */
+int fe_accum_absorb_range(struct fe_accum *a, uint32_t first, uint32_t n,
+			  const struct ed25519_pt *sum);
+
+/* Has user id contributed? */
+int fe_accum_has(const struct fe_accum *a, uint32_t id);
+
+/* Is the contributor set exactly expected, a bitmap of the same size,
+ * or every user if expected is NULL? Anything else would not match the
+ * functional decryption key for expected.
+ */
+int fe_accum_complete(const struct fe_accum *a, const uint8_t *expected);
+
+/* Copy out the sum if the contributor set is complete. Returns 1 on
+ * success, 0 if it isn't complete yet.
+ */
+int fe_accum_finalize(const struct fe_accum *a, const uint8_t *expected,
+		      struct ed25519_pt *sum);
+
+/* Partial aggregates for a hierarchy of gateways. A gateway absorbs
+ * the ciphertexts of its own sensors, and forwards its accumulator
+ * upstream in wire form: the packed sum, the count and the contributor
+ * bitmap, FE_ACCUM_WIRE_SIZE(n) bytes in all. The next level merges
+ * what it receives, so the central aggregator does work in proportion
+ * to the number of gateways rather than sensors.
+ *
+ * Merging adds the sums and takes the union of the contributor sets.
+ * Both are associative and commutative, so any tree of gateways gives
+ * the same result as absorbing every ciphertext in one place.
+ *
+ * The checks here cover well-formedness only. Nothing binds the sum to
+ * the contributors it claims, so a faulty or dishonest gateway can
+ * forward any point on the curve under any set of users, and the
+ * aggregator will decrypt a wrong total (or fail to find one in range)
+ * without knowing why. Gateways must be trusted to sum honestly, or the
+ * wire form carried over a channel that authenticates them.
+ */
+#define FE_ACCUM_WIRE_SIZE(n)  (ED25519_PACK_SIZE + 4 + FE_ACCUM_BITMAP_SIZE(n))
+
+/* a += b. Returns 1 on success, or 0 (leaving a unchanged) if the two
+ * were set up for different numbers of users, or have a contributor in
+ * common, whose ciphertext would otherwise be counted twice.
+ */
+int fe_accum_merge(struct fe_accum *a, const struct fe_accum *b);
+
+/* Write a's wire form to buf. This normalizes the sum, at the cost of
+ * one inversion.
+ */
+void fe_accum_pack(const struct fe_accum *a, uint8_t *buf);
+
+/* Set a up from a wire form for n users, with bitmap as for
+ * fe_accum_init(). The message is checked before it is used: the sum
+ * must be a point on the curve, no contributor may be out of range, and
+ * the count must match the bitmap. Returns 1 if it passed, or 0 if not.
+ */
+int fe_accum_unpack(struct fe_accum *a, uint8_t *bitmap, uint32_t n,
+		    const uint8_t *buf);
+
+#endif
@@ -0,0 +1,52 @@
+/* Reproducible per-user key generation
+ *
+ * This file is in the public domain.
+ */
+
+#include "fe-keygen.h"
+
+#define SPLITMIX_GAMMA  0x9e3779b97f4a7c15ULL
+
+static uint64_t splitmix_mix(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+void fe_rng_init(struct fe_rng *r, uint64_t seed, uint64_t stream)
+{
+	/* Mixing the stream number before combining it with the seed
+	 * keeps neighbouring streams from being shifted copies of each
+	 * other.
+	 */
+	r->state = splitmix_mix(seed ^ splitmix_mix(stream + SPLITMIX_GAMMA));
+}
+
+uint64_t fe_rng_next(struct fe_rng *r)
+{
+	r->state += SPLITMIX_GAMMA;
+	return splitmix_mix(r->state);
+}
+
+void fe_rng_bytes(struct fe_rng *r, uint8_t *buf, unsigned int len)
+{
+	while (len) {
+		uint64_t w = fe_rng_next(r);
+		unsigned int i;
+
+		for (i = 0; i < 8 && len; i++, len--) {
+			*(buf++) = w;
+			w >>= 8;
+		}
+	}
+}
+
+void fe_keygen_user(uint8_t *key, uint64_t seed, uint32_t id)
+{
+	struct fe_rng r;
+
+	fe_rng_init(&r, seed, id);
+	fe_rng_bytes(&r, key, C25519_EXPONENT_SIZE);
+	c25519_prepare(key);
+}
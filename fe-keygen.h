@@ -0,0 +1,35 @@
+/* Reproducible per-user key generation
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef FE_KEYGEN_H_
+#define FE_KEYGEN_H_
+
+#include <stdint.h>
+
+#include "c25519.h"
+
+/* Every user draws its secret key from its own random stream, selected
+ * by (seed, user id), rather than from the shared rand() state. A key
+ * then doesn't depend on which thread generates it, or in what order,
+ * so a parallel setup gives the same keys as a sequential one for the
+ * same seed.
+ *
+ * The streams are SplitMix64 sequences. Like rand(), they are meant for
+ * reproducible experiments, not for keys that must resist an attacker.
+ */
+struct fe_rng {
+	uint64_t  state;
+};
+
+void fe_rng_init(struct fe_rng *r, uint64_t seed, uint64_t stream);
+uint64_t fe_rng_next(struct fe_rng *r);
+
+/* Fill buf with len bytes from the stream */
+void fe_rng_bytes(struct fe_rng *r, uint8_t *buf, unsigned int len);
+
+/* Generate user id's secret key for seed, clamped by c25519_prepare() */
+void fe_keygen_user(uint8_t *key, uint64_t seed, uint32_t id);
+
+#endif
@@ -0,0 +1,100 @@
+/* Membership and dropout-tolerant decryption keys
+ *
+ * This file is in the public domain.
+ */
+
+#include "fe-members.h"
+
+void fe_members_init(struct fe_members *m, uint8_t *bitmap, uint32_t n,
+		     const uint32_t *fdk)
+{
+	m->roster = bitmap;
+	m->n = n;
+
+	if (!fdk) {
+		sc25519_load(m->fdk, 0);
+		m->count = 0;
+		memset(bitmap, 0, FE_ACCUM_BITMAP_SIZE(n));
+		return;
+	}
+
+	sc25519_copy(m->fdk, fdk);
+	m->count = n;
+	memset(bitmap, 0xff, FE_ACCUM_BITMAP_SIZE(n));
+	if (n & 7)
+		bitmap[n >> 3] = (1 << (n & 7)) - 1;
+}
+
+int fe_members_has(const struct fe_members *m, uint32_t id)
+{
+	if (id >= m->n)
+		return 0;
+
+	return (m->roster[id >> 3] >> (id & 7)) & 1;
+}
+
+int fe_members_join(struct fe_members *m, uint32_t id, const uint8_t *key)
+{
+	uint32_t s[SC25519_WORDS];
+
+	if (id >= m->n || fe_members_has(m, id))
+		return 0;
+
+	sc25519_from_bytes(s, key);
+	sc25519_add(m->fdk, m->fdk, s);
+
+	m->roster[id >> 3] |= 1 << (id & 7);
+	m->count++;
+	return 1;
+}
+
+int fe_members_leave(struct fe_members *m, uint32_t id, const uint8_t *key)
+{
+	uint32_t s[SC25519_WORDS];
+
+	if (!fe_members_has(m, id))
+		return 0;
+
+	sc25519_from_bytes(s, key);
+	sc25519_sub(m->fdk, m->fdk, s);
+
+	m->roster[id >> 3] &= ~(1 << (id & 7));
+	m->count--;
+	return 1;
+}
+
+int fe_members_round_key(const struct fe_members *m,
+			 const struct fe_accum *acc,
+			 const uint8_t *const *keys, uint32_t *fdk)
+{
+	const uint32_t nbytes = FE_ACCUM_BITMAP_SIZE(m->n);
+	uint32_t s[SC25519_WORDS];
+	uint32_t i;
+
+	if (acc->n != m->n)
+		return 0;
+
+	/* Bits past n are clear in both bitmaps, so they never show up
+	 * as either kind of mismatch.
+	 */
+	for (i = 0; i < nbytes; i++)
+		if (acc->seen[i] & ~m->roster[i])
+			return 0;
+
+	sc25519_copy(fdk, m->fdk);
+
+	for (i = 0; i < nbytes; i++) {
+		uint8_t missing = m->roster[i] & ~acc->seen[i];
+		int bit;
+
+		for (bit = 0; missing; bit++, missing >>= 1) {
+			if (!(missing & 1))
+				continue;
+
+			sc25519_from_bytes(s, keys[i * 8 + bit]);
+			sc25519_sub(fdk, fdk, s);
+		}
+	}
+
+	return 1;
+}
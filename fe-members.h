@@ -0,0 +1,62 @@
+/* Membership and dropout-tolerant decryption keys
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef FE_MEMBERS_H_
+#define FE_MEMBERS_H_
+
+#include <stdint.h>
+
+#include "sc25519.h"
+#include "fe-accum.h"
+
+/* The key authority's view of who takes part in aggregation: a roster
+ * bitmap of users 0 .. n-1, and the functional decryption key for the
+ * whole roster, FDK = sum(s_i) mod l over members i. Joins and leaves
+ * add or subtract one secret key, so the FDK never has to be derived
+ * again from scratch.
+ *
+ * When a round closes with some members missing, fe_members_round_key()
+ * derives the key for the users who did report, by subtracting the k
+ * missing keys from the roster FDK. Finding them scans the bitmaps a
+ * byte at a time; only the missing users cost scalar arithmetic.
+ *
+ * The bitmap is supplied by the caller, and should have room for
+ * FE_ACCUM_BITMAP_SIZE(n) bytes.
+ */
+struct fe_members {
+	uint32_t  fdk[SC25519_WORDS];
+	uint8_t   *roster;
+	uint32_t  n;
+	uint32_t  count;
+};
+
+/* Start with an empty roster if fdk is NULL. Otherwise every user is a
+ * member, and fdk is the key for all of them, e.g. from
+ * fe_fdk_parallel().
+ */
+void fe_members_init(struct fe_members *m, uint8_t *bitmap, uint32_t n,
+		     const uint32_t *fdk);
+
+/* Is user id on the roster? */
+int fe_members_has(const struct fe_members *m, uint32_t id);
+
+/* Add or remove user id, whose secret key is key. Returns 1 on success,
+ * or 0 if id is out of range, or already is (or isn't) a member.
+ */
+int fe_members_join(struct fe_members *m, uint32_t id, const uint8_t *key);
+int fe_members_leave(struct fe_members *m, uint32_t id, const uint8_t *key);
+
+/* Derive the key for the users whose ciphertexts acc holds, into fdk.
+ * keys[i] is user i's secret key, and is only read for members missing
+ * from acc. Returns 1 on success, or 0 if acc holds a ciphertext from
+ * a non-member, or was set up for a different number of users. The
+ * result matches acc's contributor set, so decrypt acc's sum with it
+ * (fe_accum_finalize() with acc's own bitmap as expected).
+ */
+int fe_members_round_key(const struct fe_members *m,
+			 const struct fe_accum *acc,
+			 const uint8_t *const *keys, uint32_t *fdk);
+
+#endif
@@ -0,0 +1,209 @@
+/* Parallel helpers for the sumFE native simulator
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdlib.h>
+
+#include "fe-parallel.h"
+#include "fe-keygen.h"
+
+struct fdk_job {
+	const uint8_t *const	*keys;
+	unsigned int		n;
+	uint32_t		partial[TPOOL_MAX_THREADS][SC25519_WORDS];
+};
+
+static void fdk_worker(void *arg, unsigned int idx, unsigned int nthreads)
+{
+	struct fdk_job *job = arg;
+	unsigned int begin, end;
+
+	tpool_range(job->n, idx, nthreads, &begin, &end);
+	sc25519_sum(job->partial[idx], job->keys + begin, end - begin);
+}
+
+void fe_fdk_parallel(struct tpool *pool, uint32_t *fdk,
+		     const uint8_t *const *keys, unsigned int n)
+{
+	struct fdk_job job;
+	unsigned int stride;
+	unsigned int i;
+
+	job.keys = keys;
+	job.n = n;
+	tpool_run(pool, fdk_worker, &job);
+
+	/* Tree reduction: after the pass with a given stride, slot i
+	 * (a multiple of 2 * stride) holds the sum of the 2 * stride
+	 * ranges starting at i.
+	 */
+	for (stride = 1; stride < pool->nthreads; stride <<= 1)
+		for (i = 0; i + stride < pool->nthreads; i += stride << 1)
+			sc25519_add(job.partial[i], job.partial[i],
+				    job.partial[i + stride]);
+
+	sc25519_copy(fdk, job.partial[0]);
+}
+
+struct point_sum_job {
+	const struct ed25519_pt	*pts;
+	unsigned int		n;
+	struct ed25519_pt	partial[TPOOL_MAX_THREADS];
+};
+
+static void point_sum_worker(void *arg, unsigned int idx,
+			     unsigned int nthreads)
+{
+	struct point_sum_job *job = arg;
+	struct ed25519_pt *acc = &job->partial[idx];
+	unsigned int begin, end, i;
+
+	tpool_range(job->n, idx, nthreads, &begin, &end);
+
+	ed25519_copy(acc, &ed25519_neutral);
+	for (i = begin; i < end; i++)
+		ed25519_add_assign(acc, &job->pts[i]);
+}
+
+void fe_point_sum_parallel(struct tpool *pool, struct ed25519_pt *sum,
+			   const struct ed25519_pt *pts, unsigned int n)
+{
+	struct point_sum_job job;
+	unsigned int stride;
+	unsigned int i;
+
+	job.pts = pts;
+	job.n = n;
+	tpool_run(pool, point_sum_worker, &job);
+
+	for (stride = 1; stride < pool->nthreads; stride <<= 1)
+		for (i = 0; i + stride < pool->nthreads; i += stride << 1)
+			ed25519_add_assign(&job.partial[i],
+					   &job.partial[i + stride]);
+
+	ed25519_copy(sum, &job.partial[0]);
+}
+
+struct keygen_job {
+	uint64_t			seed;
+	uint8_t *const			*skeys;
+	struct ed25519_pt *const	*pkeys;
+	const struct ed25519_pt		*base;
+	unsigned int			n;
+};
+
+static void keygen_worker(void *arg, unsigned int idx, unsigned int nthreads)
+{
+	struct keygen_job *job = arg;
+	const struct ed25519_pt *bases[FE_KEYGEN_BLOCK];
+	const uint8_t *scalars[FE_KEYGEN_BLOCK];
+	unsigned int begin, end, j, i;
+
+	tpool_range(job->n, idx, nthreads, &begin, &end);
+
+	for (i = 0; i < FE_KEYGEN_BLOCK; i++)
+		bases[i] = job->base;
+
+	for (j = begin; j < end; j += FE_KEYGEN_BLOCK) {
+		const unsigned int n = (end - j < FE_KEYGEN_BLOCK) ?
+			end - j : FE_KEYGEN_BLOCK;
+
+		for (i = 0; i < n; i++) {
+			fe_keygen_user(job->skeys[j + i], job->seed, j + i);
+			scalars[i] = job->skeys[j + i];
+		}
+
+		ed25519_smult_batch(job->pkeys + j, bases, scalars, n);
+	}
+}
+
+void fe_keygen_parallel(struct tpool *pool, uint64_t seed,
+			uint8_t *const *skeys, struct ed25519_pt *const *pkeys,
+			const struct ed25519_pt *base, unsigned int n)
+{
+	struct keygen_job job;
+
+	job.seed = seed;
+	job.skeys = skeys;
+	job.pkeys = pkeys;
+	job.base = base;
+	job.n = n;
+
+	tpool_run(pool, keygen_worker, &job);
+}
+
+struct dlog_build_job {
+	struct dlog_table	*t;
+	struct ed25519_affine	step;
+	int			failed;
+};
+
+static void dlog_build_worker(void *arg, unsigned int idx,
+			      unsigned int nthreads)
+{
+	struct dlog_build_job *job = arg;
+	struct dlog_table *t = job->t;
+	struct ed25519_pt *pts = malloc(FE_DLOG_BLOCK * sizeof(*pts));
+	uint8_t *xs = malloc(FE_DLOG_BLOCK * F25519_SIZE);
+	uint8_t *ys = malloc(FE_DLOG_BLOCK * F25519_SIZE);
+	uint8_t *scratch = malloc(FE_DLOG_BLOCK * F25519_SIZE);
+	uint8_t e[ED25519_EXPONENT_SIZE];
+	struct ed25519_pt p;
+	unsigned int begin, end, j;
+
+	if (!pts || !xs || !ys || !scratch) {
+		__atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+		goto out;
+	}
+
+	tpool_range(t->m, idx, nthreads, &begin, &end);
+
+	/* p = begin*base */
+	f25519_load(e, begin);
+	ed25519_smult_bounded(&p, &t->base, e, 32);
+
+	for (j = begin; j < end; j += FE_DLOG_BLOCK) {
+		const unsigned int n = (end - j < FE_DLOG_BLOCK) ?
+			end - j : FE_DLOG_BLOCK;
+		unsigned int i;
+
+		for (i = 0; i < n; i++) {
+			ed25519_copy(&pts[i], &p);
+			ed25519_add_affine(&p, &p, &job->step);
+		}
+
+		ed25519_unproject_batch(xs, ys, pts, n, scratch);
+
+		for (i = 0; i < n; i++) {
+			uint8_t key[ED25519_PACK_SIZE];
+
+			ed25519_pack(key, xs + i * F25519_SIZE,
+				     ys + i * F25519_SIZE);
+			if (!dlog_table_insert(t, key, j + i)) {
+				__atomic_store_n(&job->failed, 1,
+						 __ATOMIC_RELAXED);
+				goto out;
+			}
+		}
+	}
+
+out:
+	free(pts);
+	free(xs);
+	free(ys);
+	free(scratch);
+}
+
+int fe_dlog_build_parallel(struct tpool *pool, struct dlog_table *t)
+{
+	struct dlog_build_job job;
+
+	job.t = t;
+	job.failed = 0;
+	ed25519_affine_prepare(&job.step, &t->base);
+
+	tpool_run(pool, dlog_build_worker, &job);
+
+	return !job.failed;
+}
@@ -0,0 +1,59 @@
+/* Parallel helpers for the sumFE native simulator
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef FE_PARALLEL_H_
+#define FE_PARALLEL_H_
+
+#include <stdint.h>
+
+#include "tpool.h"
+#include "sc25519.h"
+#include "dlog.h"
+#include "ed25519.h"
+
+/* Derive the functional decryption key FDK = sum(keys[i]) mod l. The
+ * key array is split into one contiguous range per pool thread, each
+ * range is summed with sc25519_sum(), and the partial sums are merged
+ * pairwise in a binary tree. Addition mod l is exact, so the result
+ * doesn't depend on the number of threads.
+ */
+void fe_fdk_parallel(struct tpool *pool, uint32_t *fdk,
+		     const uint8_t *const *keys, unsigned int n);
+
+/* Sum n points, such as the ciphertexts of every user, into sum. Each
+ * pool thread folds a contiguous range into a partial sum, and the
+ * partial sums are merged pairwise in a binary tree, as for the FDK.
+ * The projective coordinates depend on the number of threads, but the
+ * point (and so its packed form) does not.
+ */
+void fe_point_sum_parallel(struct tpool *pool, struct ed25519_pt *sum,
+			   const struct ed25519_pt *pts, unsigned int n);
+
+/* Generate n key pairs: skeys[i] = fe_keygen_user(seed, i), and
+ * pkeys[i] = skeys[i] * base. The user range is split into one
+ * contiguous range per pool thread, and each thread computes its public
+ * keys FE_KEYGEN_BLOCK at a time with ed25519_smult_batch(). Keys come
+ * from per-user streams, so the result is identical to the sequential
+ * loop for the same seed, whatever the number of threads.
+ */
+#define FE_KEYGEN_BLOCK  64
+
+void fe_keygen_parallel(struct tpool *pool, uint64_t seed,
+			uint8_t *const *skeys, struct ed25519_pt *const *pkeys,
+			const struct ed25519_pt *base, unsigned int n);
+
+/* Fill a table set up by dlog_table_init() with j*base for 0 <= j < m.
+ * Each pool thread takes a contiguous range of j, starting from one
+ * bounded multiplication, and walks it with mixed additions of the
+ * affine base. Points are normalized FE_DLOG_BLOCK at a time with a
+ * single inversion, and inserted with dlog_table_insert(), which takes
+ * no lock on the common path. Returns 1 on success, or 0 if memory ran
+ * out or an entry could not be placed.
+ */
+#define FE_DLOG_BLOCK  256
+
+int fe_dlog_build_parallel(struct tpool *pool, struct dlog_table *t);
+
+#endif
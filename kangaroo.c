@@ -0,0 +1,338 @@
+/* Parallel Pollard kangaroo discrete logarithms
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdlib.h>
+
+#include "kangaroo.h"
+#include "dlog.h"
+
+/* Jump sizes are 2^0 .. 2^(njumps-1) */
+#define KANGAROO_MAX_JUMPS  62
+
+/* Cap on the distinguished-point table, in slots */
+#define KANGAROO_MAX_SLOTS  (1UL << 26)
+
+/* Distinguished points. key is a 64-bit fingerprint of the compressed
+ * point (never 0), and val is (distance << 1 | wild) + 1 (never 0).
+ * Slots are claimed by compare-and-swap on key; a reader that finds
+ * its key but not yet a val spins until the writer stores it.
+ */
+struct kangaroo_dp {
+	uint64_t  key;
+	uint64_t  val;
+};
+
+struct kangaroo_job {
+	const struct ed25519_pt		*base;
+	const struct ed25519_pt		*target;
+	uint8_t				target_key[ED25519_PACK_SIZE];
+	uint64_t			bound;
+	uint64_t			spread;
+
+	unsigned int			walkers;
+	uint32_t			dp_mask;
+	unsigned int			njumps;
+	struct ed25519_pt		jump[KANGAROO_MAX_JUMPS];
+
+	struct kangaroo_dp		*dps;
+	uint64_t			nslots;
+
+	uint64_t			budget;
+	uint64_t			steps;
+
+	/* 0 while running, 1 if out of budget, 2 if solved */
+	int				done;
+	uint64_t			result;
+};
+
+static uint64_t isqrt64(uint64_t n)
+{
+	uint64_t r = 0;
+	int b;
+
+	for (b = 31; b >= 0; b--) {
+		const uint64_t t = r | (1ULL << b);
+
+		if (t * t <= n)
+			r = t;
+	}
+
+	return r;
+}
+
+static uint32_t load32(const uint8_t *b)
+{
+	return ((uint32_t)b[0]) |
+	       (((uint32_t)b[1]) << 8) |
+	       (((uint32_t)b[2]) << 16) |
+	       (((uint32_t)b[3]) << 24);
+}
+
+static uint64_t xorshift64(uint64_t *s)
+{
+	uint64_t x = *s;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*s = x;
+
+	return x;
+}
+
+/* r = k*base for a 64-bit k */
+static void smult64(struct ed25519_pt *r, const struct ed25519_pt *base,
+		    uint64_t k)
+{
+	uint8_t e[ED25519_EXPONENT_SIZE] = {0};
+	int i;
+
+	for (i = 0; i < 8; i++)
+		e[i] = k >> (i * 8);
+
+	ed25519_smult_bounded(r, base, e, 64);
+}
+
+uint64_t kangaroo_expected_steps(uint64_t bound, unsigned int nwalkers,
+				 unsigned int dp_bits)
+{
+	return 2 * isqrt64(bound) +
+	       ((uint64_t)nwalkers << dp_bits);
+}
+
+/* Start a walker at a random point of its herd */
+static void kangaroo_seed(const struct kangaroo_job *job,
+			  struct ed25519_pt *pos, uint64_t *dist,
+			  int wild, uint64_t *rng)
+{
+	*dist = xorshift64(rng) % job->spread;
+
+	if (wild) {
+		smult64(pos, job->base, *dist);
+		ed25519_add_assign(pos, job->target);
+	} else {
+		*dist += job->bound / 2;
+		smult64(pos, job->base, *dist);
+	}
+}
+
+/* Check a candidate answer by recomputing it */
+static void kangaroo_try(struct kangaroo_job *job, uint64_t tame,
+			 uint64_t wild)
+{
+	uint8_t key[ED25519_PACK_SIZE];
+	struct ed25519_pt p;
+	uint64_t v;
+
+	if (tame < wild)
+		return;
+
+	v = tame - wild;
+	if (v > job->bound)
+		return;
+
+	smult64(&p, job->base, v);
+	dlog_encode(key, &p);
+	if (memcmp(key, job->target_key, sizeof(key)))
+		return;
+
+	/* v is unique in range, so racing finders store the same value */
+	__atomic_store_n(&job->result, v, __ATOMIC_RELAXED);
+	__atomic_store_n(&job->done, 2, __ATOMIC_RELEASE);
+}
+
+/* Record a distinguished point. Returns 1 if the walker collided with
+ * another of its own herd, and so should be restarted.
+ */
+static int kangaroo_record(struct kangaroo_job *job, uint64_t fp,
+			   uint64_t dist, int wild)
+{
+	const uint64_t val = ((dist << 1) | wild) + 1;
+	uint64_t i = fp & (job->nslots - 1);
+	uint64_t n;
+
+	for (n = 0; n < job->nslots; n++) {
+		struct kangaroo_dp *d = &job->dps[i];
+		uint64_t key = 0;
+		uint64_t other;
+
+		if (__atomic_compare_exchange_n(&d->key, &key, fp, 0,
+						__ATOMIC_ACQ_REL,
+						__ATOMIC_ACQUIRE)) {
+			__atomic_store_n(&d->val, val, __ATOMIC_RELEASE);
+			return 0;
+		}
+
+		if (key != fp) {
+			i = (i + 1) & (job->nslots - 1);
+			continue;
+		}
+
+		while (!(other = __atomic_load_n(&d->val, __ATOMIC_ACQUIRE)))
+			;
+		other--;
+
+		if ((int)(other & 1) == wild)
+			return 1;
+
+		if (wild)
+			kangaroo_try(job, other >> 1, dist);
+		else
+			kangaroo_try(job, dist, other >> 1);
+
+		return 0;
+	}
+
+	/* Table full: drop the point */
+	return 0;
+}
+
+static void kangaroo_worker(void *arg, unsigned int idx,
+			    unsigned int nthreads)
+{
+	struct kangaroo_job *job = arg;
+	const unsigned int w = job->walkers;
+	struct ed25519_pt *pos = malloc(w * sizeof(*pos));
+	uint64_t *dist = malloc(w * sizeof(*dist));
+	uint8_t *xs = malloc(w * F25519_SIZE);
+	uint8_t *ys = malloc(w * F25519_SIZE);
+	uint8_t *scratch = malloc(w * F25519_SIZE);
+	uint64_t rng = 0x9e3779b97f4a7c15ULL * (idx + 1);
+	unsigned int i;
+
+	(void)nthreads;
+
+	if (!pos || !dist || !xs || !ys || !scratch)
+		goto out;
+
+	for (i = 0; i < w; i++)
+		kangaroo_seed(job, &pos[i], &dist[i], i & 1, &rng);
+
+	while (!__atomic_load_n(&job->done, __ATOMIC_ACQUIRE)) {
+		ed25519_unproject_batch(xs, ys, pos, w, scratch);
+
+		for (i = 0; i < w; i++) {
+			uint8_t c[ED25519_PACK_SIZE];
+			uint64_t fp;
+			unsigned int j;
+
+			ed25519_pack(c, xs + i * F25519_SIZE,
+				     ys + i * F25519_SIZE);
+
+			/* Independent bytes of y for the fingerprint,
+			 * distinguishing test and jump choice.
+			 */
+			fp = ((uint64_t)load32(c + 4) << 32) | load32(c);
+			if (!fp)
+				fp = 1;
+
+			if (!(load32(c + 8) & job->dp_mask) &&
+			    kangaroo_record(job, fp, dist[i], i & 1)) {
+				kangaroo_seed(job, &pos[i], &dist[i],
+					      i & 1, &rng);
+				continue;
+			}
+
+			j = load32(c + 12) % job->njumps;
+			ed25519_add_assign(&pos[i], &job->jump[j]);
+			dist[i] += 1ULL << j;
+		}
+
+		if (__atomic_add_fetch(&job->steps, w, __ATOMIC_RELAXED) >
+		    job->budget) {
+			int running = 0;
+
+			__atomic_compare_exchange_n(&job->done, &running, 1,
+						    0, __ATOMIC_ACQ_REL,
+						    __ATOMIC_ACQUIRE);
+		}
+	}
+
+out:
+	free(pos);
+	free(dist);
+	free(xs);
+	free(ys);
+	free(scratch);
+}
+
+int kangaroo_solve(struct tpool *pool, const struct kangaroo_cfg *cfg,
+		   const struct ed25519_pt *base,
+		   const struct ed25519_pt *target,
+		   uint64_t bound, uint64_t *v)
+{
+	struct kangaroo_job *job = malloc(sizeof(*job));
+	unsigned int walkers = (cfg->walkers + 1) & ~1U;
+	unsigned int dp_bits = cfg->dp_bits;
+	uint64_t nwalkers, mean, budget, ndp;
+	int ret = 0;
+	unsigned int i;
+
+	if (!job)
+		return 0;
+
+	if (walkers < 2)
+		walkers = 2;
+	nwalkers = (uint64_t)walkers * pool->nthreads;
+
+	budget = cfg->budget;
+	if (!budget)
+		budget = 4 * kangaroo_expected_steps(bound, nwalkers, 0);
+
+	/* Keep the tail, about nwalkers * 2^dp_bits steps, at 1/32 of
+	 * the budget.
+	 */
+	if (!dp_bits)
+		while (dp_bits < 30 &&
+		       (nwalkers << (dp_bits + 1)) <= budget / 32)
+			dp_bits++;
+
+	/* Mean jump sqrt(bound) * nwalkers / 4, with jumps 2^0 ..
+	 * 2^(k-1) averaging (2^k - 1) / k.
+	 */
+	mean = isqrt64(bound) * nwalkers / 4;
+	job->njumps = 1;
+	while (job->njumps < KANGAROO_MAX_JUMPS &&
+	       ((1ULL << job->njumps) - 1) / job->njumps < mean)
+		job->njumps++;
+
+	ed25519_copy(&job->jump[0], base);
+	for (i = 1; i < job->njumps; i++)
+		ed25519_double(&job->jump[i], &job->jump[i - 1]);
+
+	/* Enough room for every distinguished point the budget allows */
+	ndp = (budget >> dp_bits) * 2 + 64;
+	job->nslots = 64;
+	while (job->nslots < ndp && job->nslots < KANGAROO_MAX_SLOTS)
+		job->nslots <<= 1;
+
+	job->dps = calloc(job->nslots, sizeof(*job->dps));
+	if (!job->dps) {
+		free(job);
+		return 0;
+	}
+
+	job->base = base;
+	job->target = target;
+	dlog_encode(job->target_key, target);
+	job->bound = bound;
+	job->spread = mean ? mean : 1;
+	job->walkers = walkers;
+	job->dp_mask = (1UL << dp_bits) - 1;
+	job->budget = budget;
+	job->steps = 0;
+	job->done = 0;
+
+	tpool_run(pool, kangaroo_worker, job);
+
+	if (job->done == 2) {
+		*v = job->result;
+		ret = 1;
+	}
+
+	free(job->dps);
+	free(job);
+	return ret;
+}
@@ -0,0 +1,67 @@
+/* Parallel Pollard kangaroo discrete logarithms
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef KANGAROO_H_
+#define KANGAROO_H_
+
+#include <stdint.h>
+
+#include "ed25519.h"
+#include "tpool.h"
+
+/* Recover v from v*base, given 0 <= v <= bound, using van Oorschot and
+ * Wiener's parallel kangaroo (lambda) method. Needs O(sqrt(bound))
+ * point additions but almost no memory, so it takes over from the
+ * baby-step table (dlog.h) once the bound is too large for one.
+ *
+ * Every pool thread runs a block of walkers, half tame (starting near
+ * bound/2) and half wild (starting near the target). A walker's next
+ * jump, a power of two, is chosen by a hash of its current point. The
+ * walkers of a block are normalized together with one inversion per
+ * step. Points whose hash has dp_bits low zero bits are distinguished,
+ * and are recorded in a shared lock-free table; when a tame and a wild
+ * walker reach the same distinguished point, the difference of their
+ * distances is the answer. Candidates are checked by recomputing
+ * v*base before they are returned.
+ *
+ * This works on public values only, and is not constant-time.
+ *
+ *     van Oorschot, P.C. & Wiener, M.J. (1999) "Parallel collision
+ *     search with cryptanalytic applications". Journal of Cryptology
+ *     12(1), pp. 1-28.
+ */
+#define KANGAROO_DEFAULT_WALKERS  32
+
+struct kangaroo_cfg {
+	/* Walkers per thread. Rounded up to an even number. */
+	unsigned int  walkers;
+
+	/* Distinguished-point hash bits. 0 chooses a value from the
+	 * budget, so that the tail of the search (the steps taken
+	 * between the collision and the next distinguished point) is a
+	 * small fraction of it.
+	 */
+	unsigned int  dp_bits;
+
+	/* Expected-runtime target, as a total number of steps over all
+	 * threads. The solver gives up once this is spent. 0 means four
+	 * times the expected work.
+	 */
+	uint64_t      budget;
+};
+
+/* Expected total steps for a given bound and total number of walkers */
+uint64_t kangaroo_expected_steps(uint64_t bound, unsigned int nwalkers,
+				 unsigned int dp_bits);
+
+/* Solve target = v*base for 0 <= v <= bound, which must be less than
+ * 2^60. Returns 1 and sets *v on success, or 0 if the budget ran out.
+ */
+int kangaroo_solve(struct tpool *pool, const struct kangaroo_cfg *cfg,
+		   const struct ed25519_pt *base,
+		   const struct ed25519_pt *target,
+		   uint64_t bound, uint64_t *v);
+
+#endif
@@ -0,0 +1,84 @@
+/* Multi-scalar multiplication on the Edwards curve
+ *
+ * This file is in the public domain.
+ */
+
+#include "msm.h"
+
+unsigned int msm_window(unsigned int n, unsigned int nbits,
+			unsigned int nbuckets)
+{
+	unsigned long long best_cost = 0;
+	unsigned int best = 1;
+	unsigned int c;
+
+	for (c = 1; c <= MSM_MAX_WINDOW && MSM_BUCKETS(c) <= nbuckets; c++) {
+		const unsigned long long cost =
+			((unsigned long long)(nbits + c - 1) / c) *
+			(n + (2ULL << c));
+
+		if (c == 1 || cost < best_cost) {
+			best_cost = cost;
+			best = c;
+		}
+	}
+
+	return best;
+}
+
+/* Bits [pos, pos + c) of e, with bits from nbits upwards read as 0.
+ * c is at most MSM_MAX_WINDOW, so with the bit offset the window spans
+ * no more than four bytes.
+ */
+static unsigned int msm_digit(const uint8_t *e, unsigned int pos,
+			      unsigned int c, unsigned int nbits)
+{
+	const unsigned int end = (pos + c < nbits) ? pos + c : nbits;
+	const unsigned int first = pos >> 3;
+	uint32_t w = 0;
+	unsigned int b;
+
+	for (b = first; b <= (end - 1) >> 3; b++)
+		w |= ((uint32_t)e[b]) << ((b - first) * 8);
+
+	return (w >> (pos & 7)) & ((1u << (end - pos)) - 1);
+}
+
+void msm_eval(struct ed25519_pt *r, const struct ed25519_pt *const *p,
+	      const uint8_t *const *e, unsigned int n, unsigned int nbits,
+	      struct ed25519_pt *buckets, unsigned int nbuckets)
+{
+	const unsigned int c = msm_window(n, nbits, nbuckets);
+	const unsigned int nb = MSM_BUCKETS(c);
+	unsigned int w = (nbits + c - 1) / c;
+
+	ed25519_copy(r, &ed25519_neutral);
+
+	/* Horner's rule over the windows, most significant first */
+	while (w--) {
+		struct ed25519_pt run;
+		unsigned int i;
+
+		for (i = 0; i < c; i++)
+			ed25519_double_assign(r);
+
+		for (i = 0; i < nb; i++)
+			ed25519_copy(&buckets[i], &ed25519_neutral);
+
+		for (i = 0; i < n; i++) {
+			const unsigned int d = msm_digit(e[i], w * c, c, nbits);
+
+			if (d)
+				ed25519_add_assign(&buckets[d - 1], p[i]);
+		}
+
+		/* sum(d * bucket[d - 1]) = sum over k of the suffix
+		 * sums bucket[k - 1] + ... + bucket[nb - 1].
+		 */
+		ed25519_copy(&run, &ed25519_neutral);
+		for (i = nb; i--; ) {
+			ed25519_add_assign(&run, &buckets[i]);
+			ed25519_add_assign(r, &run);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+/* Multi-scalar multiplication on the Edwards curve
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef MSM_H_
+#define MSM_H_
+
+#include <stdint.h>
+
+#include "ed25519.h"
+
+/* Compute r = sum(e[i] * p[i]) for n points by Pippenger's bucket
+ * method. Each scalar is cut into windows of c bits. For every window,
+ * each point is added to the bucket of its digit, and the buckets are
+ * combined with a running sum, so the cost is about
+ *
+ *     ceil(nbits / c) * (n + 2^(c+1)) additions + nbits doublings
+ *
+ * against about 1.5 * nbits * n operations for n separate
+ * multiplications. The best c grows with n, so large sums gain the
+ * most.
+ *
+ * Only the low nbits bits of each scalar are read, which makes short
+ * scalars (such as small weights) proportionally cheaper. nbits must be
+ * between 1 and 256. The buckets are supplied by the caller: c is
+ * chosen as the cheapest window, up to MSM_MAX_WINDOW, whose
+ * MSM_BUCKETS(c) buckets fit in nbuckets (which must be at least 1).
+ *
+ * The schedule depends on the scalars, so this is for public scalars
+ * only, and is not constant-time.
+ */
+#define MSM_MAX_WINDOW  16
+#define MSM_BUCKETS(c)  ((1u << (c)) - 1)
+
+/* The window msm_eval() will use */
+unsigned int msm_window(unsigned int n, unsigned int nbits,
+			unsigned int nbuckets);
+
+void msm_eval(struct ed25519_pt *r, const struct ed25519_pt *const *p,
+	      const uint8_t *const *e, unsigned int n, unsigned int nbits,
+	      struct ed25519_pt *buckets, unsigned int nbuckets);
+
+#endif
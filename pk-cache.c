@@ -0,0 +1,206 @@
+/* LRU cache of fixed-base public-key tables
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pk-cache.h"
+
+/* Entries allocated by pk_cache_init(), before growing by doubling */
+#define PK_CACHE_FIRST  16
+
+static uint32_t pk_cache_bucket(const struct pk_cache *c, uint32_t id)
+{
+	return (id * 0x9e3779b1U) & (c->nbuckets - 1);
+}
+
+static uint32_t pk_cache_find(const struct pk_cache *c, uint32_t id)
+{
+	uint32_t e = c->heads[pk_cache_bucket(c, id)];
+
+	while (e != PK_CACHE_NONE && c->entries[e].id != id)
+		e = c->entries[e].hnext;
+
+	return e;
+}
+
+static void pk_cache_unlink(struct pk_cache *c, uint32_t e)
+{
+	struct pk_cache_entry *x = &c->entries[e];
+
+	if (x->prev != PK_CACHE_NONE)
+		c->entries[x->prev].next = x->next;
+	else
+		c->mru = x->next;
+
+	if (x->next != PK_CACHE_NONE)
+		c->entries[x->next].prev = x->prev;
+	else
+		c->lru = x->prev;
+}
+
+static void pk_cache_push(struct pk_cache *c, uint32_t e)
+{
+	struct pk_cache_entry *x = &c->entries[e];
+
+	x->prev = PK_CACHE_NONE;
+	x->next = c->mru;
+
+	if (c->mru != PK_CACHE_NONE)
+		c->entries[c->mru].prev = e;
+	else
+		c->lru = e;
+
+	c->mru = e;
+}
+
+static void pk_cache_unhash(struct pk_cache *c, uint32_t e)
+{
+	uint32_t *link = &c->heads[pk_cache_bucket(c, c->entries[e].id)];
+
+	while (*link != e)
+		link = &c->entries[*link].hnext;
+
+	*link = c->entries[e].hnext;
+}
+
+int pk_cache_init(struct pk_cache *c, size_t budget)
+{
+	size_t n = budget / sizeof(struct pk_cache_entry);
+	uint32_t i;
+
+	if (!n)
+		return 0;
+	if (n > PK_CACHE_NONE / 2)
+		n = PK_CACHE_NONE / 2;
+
+	c->nentries = n;
+	c->nbuckets = 1;
+	while (c->nbuckets < c->nentries)
+		c->nbuckets <<= 1;
+
+	c->nalloc = (c->nentries < PK_CACHE_FIRST) ?
+		c->nentries : PK_CACHE_FIRST;
+	c->entries = malloc(c->nalloc * sizeof(*c->entries));
+	c->heads = malloc(c->nbuckets * sizeof(*c->heads));
+	if (!c->entries || !c->heads) {
+		free(c->entries);
+		free(c->heads);
+		return 0;
+	}
+
+	for (i = 0; i < c->nbuckets; i++)
+		c->heads[i] = PK_CACHE_NONE;
+
+	c->used = 0;
+	c->mru = PK_CACHE_NONE;
+	c->lru = PK_CACHE_NONE;
+	c->hits = 0;
+	c->misses = 0;
+
+	return 1;
+}
+
+/* Make room for one more entry below nentries. Returns 0 if memory ran
+ * out, in which case the caller evicts instead.
+ */
+static int pk_cache_grow(struct pk_cache *c)
+{
+	uint32_t n = c->nalloc * 2;
+	struct pk_cache_entry *e;
+
+	if (n > c->nentries)
+		n = c->nentries;
+
+	e = realloc(c->entries, n * sizeof(*e));
+	if (!e)
+		return 0;
+
+	c->entries = e;
+	c->nalloc = n;
+	return 1;
+}
+
+const struct ed25519_fixed_table *pk_cache_get(struct pk_cache *c,
+					       uint32_t id,
+					       const struct ed25519_pt *pk)
+{
+	uint32_t e = pk_cache_find(c, id);
+	uint32_t b;
+
+	if (e != PK_CACHE_NONE) {
+		c->hits++;
+		pk_cache_unlink(c, e);
+		pk_cache_push(c, e);
+		return &c->entries[e].table;
+	}
+
+	c->misses++;
+
+	/* Take a free entry, or evict the least recently used */
+	if (c->used < c->nentries &&
+	    (c->used < c->nalloc || pk_cache_grow(c))) {
+		e = c->used++;
+	} else {
+		e = c->lru;
+		pk_cache_unlink(c, e);
+		pk_cache_unhash(c, e);
+	}
+
+	b = pk_cache_bucket(c, id);
+	c->entries[e].id = id;
+	c->entries[e].hnext = c->heads[b];
+	c->heads[b] = e;
+	pk_cache_push(c, e);
+
+	ed25519_fixed_prepare(&c->entries[e].table, pk);
+	return &c->entries[e].table;
+}
+
+void pk_cache_forget(struct pk_cache *c, uint32_t id)
+{
+	const uint32_t e = pk_cache_find(c, id);
+	const uint32_t last = c->used - 1;
+
+	if (e == PK_CACHE_NONE)
+		return;
+
+	pk_cache_unlink(c, e);
+	pk_cache_unhash(c, e);
+
+	/* Keep entries [0, used) in use by moving the last one down, in
+	 * place in its hash chain and recency list.
+	 */
+	if (e != last) {
+		struct pk_cache_entry *x = &c->entries[last];
+		uint32_t *link = &c->heads[pk_cache_bucket(c, x->id)];
+
+		while (*link != last)
+			link = &c->entries[*link].hnext;
+		*link = e;
+
+		if (x->prev != PK_CACHE_NONE)
+			c->entries[x->prev].next = e;
+		else
+			c->mru = e;
+
+		if (x->next != PK_CACHE_NONE)
+			c->entries[x->next].prev = e;
+		else
+			c->lru = e;
+
+		memcpy(&c->entries[e], x, sizeof(*x));
+	}
+
+	c->used--;
+}
+
+void pk_cache_destroy(struct pk_cache *c)
+{
+	free(c->entries);
+	free(c->heads);
+	c->entries = NULL;
+	c->heads = NULL;
+}
@@ -0,0 +1,78 @@
+/* LRU cache of fixed-base public-key tables
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef PK_CACHE_H_
+#define PK_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ed25519.h"
+
+/* Public keys are reused across many epochs with a fresh r each time,
+ * so r*pk can use a fixed-base table (ed25519_fixed_prepare()) once the
+ * table exists. This cache keeps the tables of the most recently used
+ * keys, up to a memory budget, and evicts the least recently used one
+ * when a new key needs room.
+ *
+ * Keys are identified by a caller-chosen id, such as the user index.
+ * The caller must not reuse an id for a different public key without
+ * calling pk_cache_forget() first.
+ *
+ * This allocates memory, and so is only built for the native target.
+ */
+#define PK_CACHE_NONE  0xffffffffU
+
+struct pk_cache_entry {
+	uint32_t			id;
+
+	/* Hash chain, and recency list (prev is more recent) */
+	uint32_t			hnext;
+	uint32_t			prev;
+	uint32_t			next;
+
+	struct ed25519_fixed_table	table;
+};
+
+struct pk_cache {
+	/* Entries are allocated as they're needed, up to nentries */
+	struct pk_cache_entry	*entries;
+	uint32_t		nentries;
+	uint32_t		nalloc;
+	uint32_t		used;
+
+	/* Hash buckets, heads of chains through hnext */
+	uint32_t		*heads;
+	uint32_t		nbuckets;
+
+	/* Most and least recently used entries */
+	uint32_t		mru;
+	uint32_t		lru;
+
+	unsigned long		hits;
+	unsigned long		misses;
+};
+
+/* Set up a cache holding as many tables as fit in budget bytes. Tables
+ * are allocated as keys first arrive, so the budget is an upper bound
+ * rather than an up-front cost. Returns 1 on success, or 0 if the
+ * budget doesn't cover one table or memory ran out.
+ */
+int pk_cache_init(struct pk_cache *c, size_t budget);
+
+/* Return the table for id, building it from pk on a miss. The pointer
+ * stays valid until the next call to pk_cache_get() or
+ * pk_cache_forget().
+ */
+const struct ed25519_fixed_table *pk_cache_get(struct pk_cache *c,
+					       uint32_t id,
+					       const struct ed25519_pt *pk);
+
+/* Drop the table for id, if cached */
+void pk_cache_forget(struct pk_cache *c, uint32_t id);
+
+void pk_cache_destroy(struct pk_cache *c);
+
+#endif
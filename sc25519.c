@@ -0,0 +1,259 @@
+/* Arithmetic mod l, the order of the Ed25519 base point
+ *
+ * This file is in the public domain.
+ */
+
+#include "sc25519.h"
+
+const uint32_t sc25519_l[SC25519_WORDS] = {
+	0x5cf5d3ed, 0x5812631a, 0xa2f79cd6, 0x14def9de,
+	0x00000000, 0x00000000, 0x00000000, 0x10000000
+};
+
+/* Barrett constant: mu = floor(2^512 / l), 260 bits */
+static const uint32_t sc25519_mu[SC25519_WORDS + 1] = {
+	0x0a2c131b, 0xed9ce5a3, 0x086329a7, 0x2106215d,
+	0xffffffeb, 0xffffffff, 0xffffffff, 0xffffffff,
+	0x0000000f
+};
+
+static uint32_t load_le32(const uint8_t *b)
+{
+	return ((uint32_t)b[0]) |
+	       (((uint32_t)b[1]) << 8) |
+	       (((uint32_t)b[2]) << 16) |
+	       (((uint32_t)b[3]) << 24);
+}
+
+void sc25519_load(uint32_t *r, uint32_t c)
+{
+	int i;
+
+	r[0] = c;
+	for (i = 1; i < SC25519_WORDS; i++)
+		r[i] = 0;
+}
+
+/* Given x < 2^32 * l in nine words, subtract l if x >= l */
+static void csub_l(uint32_t *x)
+{
+	uint32_t t[SC25519_WORDS + 1];
+	uint32_t mask;
+	uint64_t c = 0;
+	int i;
+
+	for (i = 0; i < SC25519_WORDS; i++) {
+		c = ((uint64_t)x[i]) - sc25519_l[i] - c;
+		t[i] = c;
+		c = (c >> 32) & 1;
+	}
+
+	c = ((uint64_t)x[i]) - c;
+	t[i] = c;
+
+	/* Load x-l if no underflow */
+	mask = ((c >> 32) & 1) - 1;
+	for (i = 0; i < SC25519_WORDS + 1; i++)
+		x[i] ^= mask & (x[i] ^ t[i]);
+}
+
+void sc25519_reduce(uint32_t *r, const uint32_t *x)
+{
+	/* Handbook of Applied Cryptography, Algorithm 14.42, with
+	 * b = 2^32 and k = 8:
+	 *
+	 *     q3 = floor(floor(x / b^(k-1)) mu / b^(k+1))
+	 *     r  = (x - q3 l) mod b^(k+1)
+	 *
+	 * leaves 0 <= r < 3l, which is fixed up by two conditional
+	 * subtractions.
+	 */
+	uint32_t q2[2 * SC25519_WORDS + 2] = {0};
+	const uint32_t *q3 = q2 + SC25519_WORDS + 1;
+	uint32_t t[SC25519_WORDS + 1] = {0};
+	uint64_t c;
+	int i, j;
+
+	/* q2 = q1 mu */
+	for (i = 0; i < SC25519_WORDS + 1; i++) {
+		c = 0;
+		for (j = 0; j < SC25519_WORDS + 1; j++) {
+			c += ((uint64_t)x[i + SC25519_WORDS - 1]) *
+			     sc25519_mu[j] + q2[i + j];
+			q2[i + j] = c;
+			c >>= 32;
+		}
+
+		q2[i + j] = c;
+	}
+
+	/* t = q3 l mod b^(k+1) */
+	for (i = 0; i < SC25519_WORDS + 1; i++) {
+		c = 0;
+		for (j = 0; j < SC25519_WORDS && i + j < SC25519_WORDS + 1;
+		     j++) {
+			c += ((uint64_t)q3[i]) * sc25519_l[j] + t[i + j];
+			t[i + j] = c;
+			c >>= 32;
+		}
+
+		if (i + j < SC25519_WORDS + 1)
+			t[i + j] = c;
+	}
+
+	/* t = x - t mod b^(k+1) */
+	c = 0;
+	for (i = 0; i < SC25519_WORDS + 1; i++) {
+		c = ((uint64_t)x[i]) - t[i] - c;
+		t[i] = c;
+		c = (c >> 32) & 1;
+	}
+
+	csub_l(t);
+	csub_l(t);
+	sc25519_copy(r, t);
+}
+
+void sc25519_from_bytes(uint32_t *r, const uint8_t *b)
+{
+	uint32_t x[SC25519_WORDS * 2] = {0};
+	int i;
+
+	for (i = 0; i < SC25519_WORDS; i++)
+		x[i] = load_le32(b + i * 4);
+
+	sc25519_reduce(r, x);
+}
+
+void sc25519_to_bytes(uint8_t *b, const uint32_t *a)
+{
+	int i;
+
+	for (i = 0; i < SC25519_WORDS; i++) {
+		b[i * 4] = a[i];
+		b[i * 4 + 1] = a[i] >> 8;
+		b[i * 4 + 2] = a[i] >> 16;
+		b[i * 4 + 3] = a[i] >> 24;
+	}
+}
+
+void sc25519_add(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+	uint32_t t[SC25519_WORDS + 1];
+	uint64_t c = 0;
+	int i;
+
+	/* a + b < 2l, so one subtraction is enough */
+	for (i = 0; i < SC25519_WORDS; i++) {
+		c += ((uint64_t)a[i]) + b[i];
+		t[i] = c;
+		c >>= 32;
+	}
+
+	t[i] = c;
+	csub_l(t);
+	sc25519_copy(r, t);
+}
+
+void sc25519_sub(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+	uint32_t t[SC25519_WORDS];
+	uint32_t mask;
+	uint64_t c = 0;
+	int i;
+
+	for (i = 0; i < SC25519_WORDS; i++) {
+		c = ((uint64_t)a[i]) - b[i] - c;
+		t[i] = c;
+		c = (c >> 32) & 1;
+	}
+
+	/* Add l back on underflow */
+	mask = -(uint32_t)c;
+	c = 0;
+	for (i = 0; i < SC25519_WORDS; i++) {
+		c += ((uint64_t)t[i]) + (mask & sc25519_l[i]);
+		r[i] = c;
+		c >>= 32;
+	}
+}
+
+/* x = a * b, as a 512-bit (16-word) integer */
+static void mul_wide(uint32_t *x, const uint32_t *a, const uint32_t *b)
+{
+	int i, j;
+
+	memset(x, 0, SC25519_WORDS * 2 * sizeof(*x));
+
+	for (i = 0; i < SC25519_WORDS; i++) {
+		uint64_t c = 0;
+
+		for (j = 0; j < SC25519_WORDS; j++) {
+			c += ((uint64_t)a[i]) * b[j] + x[i + j];
+			x[i + j] = c;
+			c >>= 32;
+		}
+
+		x[i + j] = c;
+	}
+}
+
+void sc25519_mul(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+	uint32_t x[SC25519_WORDS * 2];
+
+	mul_wide(x, a, b);
+	sc25519_reduce(r, x);
+}
+
+void sc25519_sum(uint32_t *r, const uint8_t *const *s, unsigned int n)
+{
+	/* Column sums: each is at most n(2^32-1) < 2^64 */
+	uint64_t acc[SC25519_WORDS] = {0};
+	uint32_t x[SC25519_WORDS * 2] = {0};
+	uint64_t c = 0;
+	unsigned int k;
+	int i;
+
+	for (k = 0; k < n; k++)
+		for (i = 0; i < SC25519_WORDS; i++)
+			acc[i] += load_le32(s[k] + i * 4);
+
+	/* Propagate carries. Each step adds less than 2^32 to a value at
+	 * most 2^64 - 2^33 + 1, so this can't overflow.
+	 */
+	for (i = 0; i < SC25519_WORDS; i++) {
+		c += acc[i];
+		x[i] = c;
+		c >>= 32;
+	}
+
+	x[i] = c;
+	sc25519_reduce(r, x);
+}
+
+void sc25519_dot(uint32_t *r, const uint8_t *const *a,
+		 const uint8_t *const *b, unsigned int n)
+{
+	uint32_t x[SC25519_WORDS * 2];
+	uint32_t p[SC25519_WORDS];
+	uint32_t q[SC25519_WORDS];
+	unsigned int k;
+	int i;
+
+	sc25519_load(r, 0);
+
+	/* The inputs are less than 2^256, so their product fits the
+	 * 512-bit reduction without converting either one first.
+	 */
+	for (k = 0; k < n; k++) {
+		for (i = 0; i < SC25519_WORDS; i++) {
+			p[i] = load_le32(a[k] + i * 4);
+			q[i] = load_le32(b[k] + i * 4);
+		}
+
+		mul_wide(x, p, q);
+		sc25519_reduce(p, x);
+		sc25519_add(r, r, p);
+	}
+}
@@ -0,0 +1,69 @@
+/* Arithmetic mod l, the order of the Ed25519 base point
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef SC25519_H_
+#define SC25519_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/* Scalars are held as little-endian arrays of native 32-bit words, and
+ * are always fully reduced (0 <= x < l) on output, where:
+ *
+ *     l = 2^252 + 27742317777372353535851937790883648493
+ *
+ * Reduction is by Barrett's method. All operations have timings which
+ * are independent of input data.
+ *
+ * Multiplying a point of order l by a scalar gives the same result
+ * whether or not the scalar has been reduced, so sums of secret keys
+ * can be kept in this form and only converted to bytes when they are
+ * needed as an exponent.
+ */
+#define SC25519_WORDS  8
+#define SC25519_SIZE   32
+
+/* The group order */
+extern const uint32_t sc25519_l[SC25519_WORDS];
+
+/* Load a small constant */
+void sc25519_load(uint32_t *r, uint32_t c);
+
+static inline void sc25519_copy(uint32_t *r, const uint32_t *a)
+{
+	memcpy(r, a, SC25519_WORDS * sizeof(*r));
+}
+
+/* Convert from/to a 32-byte little-endian string. Any 256-bit input is
+ * accepted and reduced. The output is suitable for use as an
+ * exponent.
+ */
+void sc25519_from_bytes(uint32_t *r, const uint8_t *b);
+void sc25519_to_bytes(uint8_t *b, const uint32_t *a);
+
+/* Reduce a 512-bit (16-word) integer mod l */
+void sc25519_reduce(uint32_t *r, const uint32_t *x);
+
+/* Add, subtract and multiply. The pointers are not required to be
+ * distinct.
+ */
+void sc25519_add(uint32_t *r, const uint32_t *a, const uint32_t *b);
+void sc25519_sub(uint32_t *r, const uint32_t *a, const uint32_t *b);
+void sc25519_mul(uint32_t *r, const uint32_t *a, const uint32_t *b);
+
+/* Sum n byte-string scalars mod l. Each input is converted once and
+ * the sum is carried unreduced, so there is only a single reduction at
+ * the end. n must be less than 2^32.
+ */
+void sc25519_sum(uint32_t *r, const uint8_t *const *s, unsigned int n);
+
+/* Inner product of n pairs of byte-string scalars mod l, such as a
+ * weight vector and the secret keys it applies to. Each product costs
+ * one multiplication and one reduction.
+ */
+void sc25519_dot(uint32_t *r, const uint8_t *const *a,
+		 const uint8_t *const *b, unsigned int n);
+
+#endif
@@ -2,7 +2,16 @@
 #include "c25519.h"
 #include "ed25519.h"
 #include "f25519.h"
-#include "ecc.h"
+#include "sc25519.h"
+#include "dlog.h"
+#include "fe-accum.h"
+#include "fe-keygen.h"
+#include "fe-members.h"
+#include "msm.h"
+#include "tpool.h"
+#include "fe-parallel.h"
+#include "dlog-service.h"
+#include "pk-cache.h"
 #include "energest.h"
 #include <time.h>
 
@@ -17,16 +26,131 @@
 
 #define CNT 1000
 
+//Worker threads for the parallel phases, and the population size used to
+//report how the parallel FDK derivation scales
+#ifndef FE_THREADS
+#define FE_THREADS 4
+#endif
+#define FDK_BENCH_USERS 100000
+
+//Set to 1 to run the benchmarks that take a lot of time or memory, such
+//as aggregating SUM_BENCH_POINTS ciphertexts (about 128 MB), which are
+//off by default
+#ifndef FE_BENCH
+#define FE_BENCH 0
+#endif
+
+//Public keys derived to compare batched and separate scalar multiplications
+#define SMULT_BENCH_KEYS 200
+
+//Ciphertexts summed to report how the parallel aggregation scales
+#define SUM_BENCH_POINTS 1000000
+
+//Points and weight size of the multi-scalar multiplication benchmark, and
+//the largest size also timed with separate multiplications
+#define MSM_BENCH_POINTS 100000
+#define MSM_BENCH_BITS 16
+#define MSM_BENCH_SEPARATE 10000
+
+
+//Plaintext magnitudes whose encodings m*G are precomputed, so mapping a
+//plaintext is a constant-time table scan instead of a scalar multiplication
+#define PLAIN_TABLE (PLAIN_MAX + 1)
+
+//Largest plaintext (rand() & 75), so the sum is at most CNT * PLAIN_MAX
+#define PLAIN_MAX 75
+
+//Set to 1 for signed plaintexts (rand() & 75) - PLAIN_CENTER, such as
+//corrections, whose sum is recovered from [-CNT * PLAIN_MAX, CNT * PLAIN_MAX]
+#ifndef PLAIN_SIGNED
+#define PLAIN_SIGNED 0
+#endif
+#define PLAIN_CENTER 37
+
+//Weights of the weighted-sum query, 1 .. WEIGHT_MAX by tariff band (user
+//index mod WEIGHT_MAX), so the weighted sum is at most CNT * PLAIN_MAX *
+//WEIGHT_MAX. WEIGHT_BITS is the number of bits WEIGHT_MAX needs.
+#define WEIGHT_MAX 4
+#define WEIGHT_BITS 3
+
+//Users i with i % DROPOUT_STRIDE == DROPOUT_STRIDE - 1 miss the dropout
+//round, whose sum is decrypted over the users who did report
+#define DROPOUT_STRIDE 10
+
+//Before the dropout round, user ROSTER_LEAVE leaves the roster, and user
+//ROSTER_JOIN, who left in an earlier round (if it isn't the same user),
+//joins it again
+#define ROSTER_JOIN 0
+#define ROSTER_LEAVE 1
+
+//Gateways between the users and the aggregator; user i reports to
+//gateway i % GATEWAYS
+#define GATEWAYS 8
+
+//Baby steps in the table used to recover the sum from sum*G
+#define DLOG_BABY_STEPS 512
+
+//Prebuilt table (tools/dlog-gen), mapped in place of building one
+#ifndef DLOG_TABLE_FILE
+#define DLOG_TABLE_FILE "sumfe-dlog.tbl"
+#endif
+
+//Queries in the batched decryption benchmark
+#define DLOG_BENCH_QUERIES 256
+
+//Largest change between epochs searched around the previous sum before
+//falling back to the full search, and the drift simulated per epoch
+#define DLOG_NEAR_DELTA 2048
+#define EPOCH_DRIFT 20
+
+//Signed bound past the table's reach (4m^2 for an unsigned width of twice
+//the bound), and the values checked against it, near either edge
+#define SIGNED_WIDE_BOUND (1UL << 22)
+#define SIGNED_WIDE_VALUE 4000000
+
+//Memory for cached fixed-base public-key tables (about 49 KB each), and
+//the users and epochs in the benchmark of repeated mask computation
+#ifndef PK_CACHE_BUDGET
+#define PK_CACHE_BUDGET (64UL << 20)
+#endif
+#define PK_BENCH_USERS 100
+#define PK_BENCH_EPOCHS 4
+
+//Set to 1 to derive public keys on the X-only Montgomery ladder instead
+//of the Edwards double-and-add, for benchmarking the two paths
+#ifndef KEYGEN_MONT
+#define KEYGEN_MONT 0
+#endif
+
+//Seed of the per-user key streams, so every run (and every thread count)
+//generates the same key pairs
+#ifndef KEYGEN_SEED
+#define KEYGEN_SEED 882099
+#endif
 
 //Definition of a ciphertext
 typedef struct {
     uint8_t skey[F25519_SIZE];
-    uint8_t plain[F25519_SIZE];
+    int32_t value;                  //plaintext
+    uint8_t plain[F25519_SIZE];     //plaintext mod l
     struct ed25519_pt pkey;
-    struct ed25519_pt x_map;
+    struct ed25519_affine x_map;
+    struct ed25519_pt mask;
     struct ed25519_pt C;
 } Experim;
 
+//Wall-clock time in seconds. clock() adds up CPU time over all threads, so
+//it can't show a parallel speedup.
+static double wall_clock(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//Worker pool shared by the parallel phases
+static struct tpool pool;
+
 static unsigned long to_seconds(uint64_t time)
 {
   return (unsigned long)(time / ENERGEST_SECOND);
@@ -76,26 +200,60 @@ int computePoint(uint8_t *inB, struct ed25519_pt *inP, struct ed25519_pt *outP)
     return 1;
 }
 
-//Function to encrypt a message
-int _Encrypt(struct ed25519_pt *msg, struct ed25519_pt *pk, struct ed25519_pt *C, uint8_t *r) {
-    struct ed25519_pt rY;
-    struct ed25519_pt res;
+//Function to map a small signed plaintext onto the curve, as |v|*G from
+//the table of encodings, negated if v < 0. The cost depends only on
+//PLAIN_TABLE, not on the plaintext value.
+int mapPlaintext(int32_t v, const struct ed25519_affine *table, struct ed25519_affine *out) {
+    const uint32_t neg = (uint32_t)v >> 31;
+
+    ed25519_affine_lookup(out, table, PLAIN_TABLE, (v ^ -neg) + neg);
+    ed25519_affine_cneg(out, neg);
+    return 1;
+}
+
+//Function to store a signed plaintext as a scalar mod l
+void loadPlaintext(uint8_t *out, int32_t v){
+    uint32_t s[SC25519_WORDS];
+    uint32_t zero[SC25519_WORDS];
+
+    sc25519_load(s, v < 0 ? -(uint32_t)v : (uint32_t)v);
+    if (v < 0){
+        sc25519_load(zero, 0);
+        sc25519_sub(s, zero, s);
+    }
+    sc25519_to_bytes(out, s);
+}
 
-    //compute rY
-    ed25519_smult(&rY, pk, r);
+//Function to precompute the data-independent half of an encryption, the
+//mask r*pk_i (equal to s_i*rG), e.g. while the radio is idle. r is recoded
+//once per epoch with ed25519_prepare_scalar() and shared by every user.
+int _EncryptOffline(struct ed25519_pt *pk, const struct ed25519_scalar_prep *r, struct ed25519_pt *mask) {
+    ed25519_smult_prepared(mask, pk, r);
+    return 1;
+}
 
-    //compute M + rY
-    ed25519_add(&res, msg, &rY);
-    //show_point("Q (M + rY)", &res);
+//Function to precompute the mask as _EncryptOffline() does, using a cached
+//fixed-base table of user id's public key, which is built on first use
+int _EncryptOfflineCached(struct pk_cache *cache, uint32_t id, struct ed25519_pt *pk,
+                          const struct ed25519_scalar_prep *r, struct ed25519_pt *mask) {
+    ed25519_smult_fixed(mask, pk_cache_get(cache, id, pk), r);
+    return 1;
+}
 
-    //copy contents of res into the second component of the Ciphertext struct
-    ed25519_copy(C, &res);
+//Function to encrypt a message once the reading is available: one mixed
+//addition of the mapped plaintext to the precomputed mask, C = M + rY
+int _EncryptOnline(const struct ed25519_affine *msg, const struct ed25519_pt *mask, struct ed25519_pt *C) {
+    ed25519_add_affine(C, mask, msg);
+    //show_point("Q (M + rY)", C);
 
     return 1;
 }
 
-//Function to decrypt the ciphertext
-int _Decrypt(uint8_t *sk, struct ed25519_pt *rG, struct ed25519_pt *C){
+//Function to decrypt the ciphertext. Recovers the integer m from the
+//decrypted point m*G, with 0 <= m <= bound (-bound <= m <= bound if
+//PLAIN_SIGNED), returning 0 if there is none.
+int _Decrypt(uint8_t *sk, struct ed25519_pt *rG, struct ed25519_pt *C,
+             struct dlog_service *svc, uint64_t bound, int64_t *m){
     uint8_t negS[F25519_SIZE], rY_x[F25519_SIZE], rY_y[F25519_SIZE];
     struct ed25519_pt rY;
     struct ed25519_pt _rY;
@@ -114,37 +272,437 @@ int _Decrypt(uint8_t *sk, struct ed25519_pt *rG, struct ed25519_pt *C){
     //Compute res = -sP + Q
     ed25519_add(&res, C, &_rY);
     show_point("Decrypted M", &res);
-    
+
+    uint8_t found;
+
+#if PLAIN_SIGNED
+    return dlog_service_solve_signed(svc, &res, 1, bound, m, &found);
+#else
+    uint64_t v;
+
+    if (!dlog_service_solve(svc, &res, 1, bound, &v, &found))
+        return 0;
+
+    *m = (int64_t)v;
     return 1;
+#endif
 }
 
 //Function to add 2 points on the Twisted Edwards Curve
+//(out may alias either input)
 int _addPoints(struct ed25519_pt *in1, struct ed25519_pt *in2, struct ed25519_pt *out){
-    struct ed25519_pt res;
-
-    ed25519_add(&res, in1, in2);
-    ed25519_copy(out, &res);
+    ed25519_add(out, in1, in2);
 
     return 1;
 }
 
-int _addBigInt(uint8_t *key1, uint8_t *key2, uint8_t *outkey){
-    unsigned int k1[NUM_ECC_WORDS];
-    unsigned int k2[NUM_ECC_WORDS];
-    unsigned int out[NUM_ECC_WORDS];
+//Decrypt -SIGNED_WIDE_VALUE*g and SIGNED_WIDE_VALUE*g with a signed bound
+//too wide for the table, which takes the kangaroo fallback
+void signedWideCheck(struct dlog_service *svc, const struct ed25519_pt *g){
+    struct ed25519_pt q[2];
+    uint8_t e[F25519_SIZE] = {0};
+    int64_t got[2];
+    uint8_t found[2];
+
+    for (int i = 0; i < 4; i++)
+        e[i] = SIGNED_WIDE_VALUE >> (i * 8);
+
+    ed25519_smult(&q[1], g, e);
+    ed25519_copy(&q[0], &q[1]);
+    ed25519_cneg(&q[0], 1);
+
+    double st = wall_clock();
+    dlog_service_solve_signed(svc, q, 2, SIGNED_WIDE_BOUND, got, found);
+    double tt = wall_clock() - st;
+
+    printf("Signed values ±%d within ±%lu: %f seconds, %s\n", SIGNED_WIDE_VALUE,
+           (unsigned long)SIGNED_WIDE_BOUND, tt,
+           (found[0] && found[1] && got[0] == -SIGNED_WIDE_VALUE && got[1] == SIGNED_WIDE_VALUE) ?
+           "answers match" : "MISMATCH");
+}
+
+#if FE_BENCH
+//Time SMULT_BENCH_KEYS public keys derived one at a time with ed25519_smult()
+//and together with ed25519_smult_batch(), and check both give the same keys
+void smultBatchBench(const struct ed25519_pt *g){
+    static uint8_t keys[SMULT_BENCH_KEYS][F25519_SIZE];
+    static struct ed25519_pt pk1[SMULT_BENCH_KEYS], pk2[SMULT_BENCH_KEYS];
+    struct ed25519_pt *bOut[SMULT_BENCH_KEYS];
+    const struct ed25519_pt *bBase[SMULT_BENCH_KEYS];
+    const uint8_t *bScalar[SMULT_BENCH_KEYS];
+    int bad = 0;
+
+    //Keys from their own streams, so the benchmark leaves rand() alone
+    for (int i = 0; i < SMULT_BENCH_KEYS; i++){
+        fe_keygen_user(keys[i], KEYGEN_SEED + 1, i);
+        bOut[i] = &pk2[i];
+        bBase[i] = g;
+        bScalar[i] = keys[i];
+    }
 
-    //Convert uint8_t to uECC_word for the private key
-    uECC_vli_bytesToNative(k1, key1, BITS_TO_BYTES(256));
-    uECC_vli_bytesToNative(k2, key2, BITS_TO_BYTES(256));
+    double st = wall_clock();
+    for (int i = 0; i < SMULT_BENCH_KEYS; i++)
+        ed25519_smult(&pk1[i], g, keys[i]);
+    double t1 = wall_clock() - st;
 
-    uECC_vli_add(out, k1, k2, NUM_ECC_WORDS);
+    st = wall_clock();
+    ed25519_smult_batch(bOut, bBase, bScalar, SMULT_BENCH_KEYS);
+    double t2 = wall_clock() - st;
 
-    //Convert uECC word to uint8_t
-    uECC_vli_nativeToBytes(outkey, BITS_TO_BYTES(256), out);
+    for (int i = 0; i < SMULT_BENCH_KEYS; i++){
+        uint8_t k1[ED25519_PACK_SIZE], k2[ED25519_PACK_SIZE];
 
-    return 1;
+        dlog_encode(k1, &pk1[i]);
+        dlog_encode(k2, &pk2[i]);
+        bad |= memcmp(k1, k2, sizeof(k1));
+    }
+
+    printf("%d public keys: separate %f seconds, batched %f seconds, speedup %.2fx, %s\n",
+           SMULT_BENCH_KEYS, t1, t2, t1 / t2, bad ? "MISMATCH" : "keys match");
+}
+#endif
+
+//Time the parallel FDK derivation over FDK_BENCH_USERS random keys for
+//1, 2, 4, ... FE_THREADS threads, and check every run gives the same FDK
+void fdkScaling(void){
+    uint8_t (*keys)[F25519_SIZE] = malloc(FDK_BENCH_USERS * sizeof(*keys));
+    const uint8_t **kp = malloc(FDK_BENCH_USERS * sizeof(*kp));
+    uint32_t ref[SC25519_WORDS];
+    double base = 0;
+
+    if (!keys || !kp){
+        printf("Not enough memory for %d keys\n", FDK_BENCH_USERS);
+        free(keys);
+        free(kp);
+        return;
+    }
+
+    for (int i = 0; i < FDK_BENCH_USERS; i++){
+        genKey(keys[i]);
+        kp[i] = keys[i];
+    }
+
+    for (unsigned int t = 1; t <= FE_THREADS; t <<= 1){
+        struct tpool pool;
+        uint32_t fdk[SC25519_WORDS];
+
+        if (!tpool_init(&pool, t))
+            break;
 
-} 
+        double st = wall_clock();
+        fe_fdk_parallel(&pool, fdk, kp, FDK_BENCH_USERS);
+        double tt = wall_clock() - st;
+
+        tpool_destroy(&pool);
+
+        if (t == 1){
+            sc25519_copy(ref, fdk);
+            base = tt;
+        }
+
+        printf("%2u thread(s): %f seconds, speedup %.2fx, FDK %s\n", t, tt,
+               base / tt, memcmp(ref, fdk, sizeof(fdk)) ? "MISMATCH" : "matches");
+    }
+
+    free(keys);
+    free(kp);
+}
+
+#if FE_BENCH
+//Time the parallel sum of SUM_BENCH_POINTS ciphertext-like points (the
+//multiples g, 2g, 3g, ...) for 1, 2, 4, ... FE_THREADS threads, and check
+//every run gives the same point
+void sumScaling(const struct ed25519_pt *g){
+    struct ed25519_pt *pts = malloc(SUM_BENCH_POINTS * sizeof(*pts));
+    struct ed25519_affine step;
+    struct ed25519_pt p;
+    uint8_t x[F25519_SIZE], y[F25519_SIZE];
+    uint8_t ref[ED25519_PACK_SIZE];
+    double base = 0;
+
+    if (!pts){
+        printf("Not enough memory for %d points\n", SUM_BENCH_POINTS);
+        return;
+    }
+
+    ed25519_affine_prepare(&step, g);
+    ed25519_copy(&p, g);
+    for (int i = 0; i < SUM_BENCH_POINTS; i++){
+        ed25519_copy(&pts[i], &p);
+        ed25519_add_affine(&p, &p, &step);
+    }
+
+    for (unsigned int t = 1; t <= FE_THREADS; t <<= 1){
+        struct tpool pool;
+        struct ed25519_pt sum;
+        uint8_t packed[ED25519_PACK_SIZE];
+
+        if (!tpool_init(&pool, t))
+            break;
+
+        double st = wall_clock();
+        fe_point_sum_parallel(&pool, &sum, pts, SUM_BENCH_POINTS);
+        double tt = wall_clock() - st;
+
+        tpool_destroy(&pool);
+
+        ed25519_unproject(x, y, &sum);
+        ed25519_pack(packed, x, y);
+
+        if (t == 1){
+            memcpy(ref, packed, sizeof(ref));
+            base = tt;
+        }
+
+        printf("%2u thread(s): %f seconds, speedup %.2fx, sum %s\n", t, tt,
+               base / tt, memcmp(ref, packed, sizeof(ref)) ? "MISMATCH" : "matches");
+    }
+
+    free(pts);
+}
+#endif
+
+#if FE_BENCH
+//Time sum(w_i P_i) for 10^3, 10^4, ... MSM_BENCH_POINTS points and random
+//MSM_BENCH_BITS-bit weights as one multi-scalar multiplication, and as
+//separate multiplications up to MSM_BENCH_SEPARATE points. P_i = (i+1)g,
+//so the result is checked against one multiplication by sum(w_i (i+1)).
+void msmScaling(const struct ed25519_pt *g){
+    struct ed25519_pt *pts = malloc(MSM_BENCH_POINTS * sizeof(*pts));
+    uint8_t (*w)[SC25519_SIZE] = calloc(MSM_BENCH_POINTS, sizeof(*w));
+    const struct ed25519_pt **pp = malloc(MSM_BENCH_POINTS * sizeof(*pp));
+    const uint8_t **wp = malloc(MSM_BENCH_POINTS * sizeof(*wp));
+    struct ed25519_pt *buckets = malloc(MSM_BUCKETS(MSM_MAX_WINDOW) * sizeof(*buckets));
+    struct ed25519_affine step;
+    struct ed25519_pt p;
+
+    if (!pts || !w || !pp || !wp || !buckets){
+        printf("Not enough memory for %d points\n", MSM_BENCH_POINTS);
+        goto out;
+    }
+
+    ed25519_affine_prepare(&step, g);
+    ed25519_copy(&p, g);
+    for (int i = 0; i < MSM_BENCH_POINTS; i++){
+        ed25519_copy(&pts[i], &p);
+        ed25519_add_affine(&p, &p, &step);
+
+        w[i][0] = rand();
+        w[i][1] = rand();
+        pp[i] = &pts[i];
+        wp[i] = w[i];
+    }
+
+    for (unsigned int n = 1000; n <= MSM_BENCH_POINTS; n *= 10){
+        uint8_t e[ED25519_EXPONENT_SIZE] = {0};
+        uint8_t got[ED25519_PACK_SIZE], want[ED25519_PACK_SIZE];
+        struct ed25519_pt r;
+        uint64_t expect = 0;
+
+        for (unsigned int i = 0; i < n; i++)
+            expect += (uint64_t)(w[i][0] | (w[i][1] << 8)) * (i + 1);
+        for (int k = 0; k < 8; k++)
+            e[k] = expect >> (k * 8);
+
+        ed25519_smult_bounded(&r, g, e, 64);
+        dlog_encode(want, &r);
+
+        double st = wall_clock();
+        msm_eval(&r, pp, wp, n, MSM_BENCH_BITS, buckets, MSM_BUCKETS(MSM_MAX_WINDOW));
+        double t1 = wall_clock() - st;
+
+        dlog_encode(got, &r);
+        printf("%6u weights: MSM (window %u) %f seconds, result %s", n,
+               msm_window(n, MSM_BENCH_BITS, MSM_BUCKETS(MSM_MAX_WINDOW)), t1,
+               memcmp(got, want, sizeof(got)) ? "MISMATCH" : "matches");
+
+        if (n <= MSM_BENCH_SEPARATE){
+            struct ed25519_pt t;
+
+            st = wall_clock();
+            ed25519_copy(&r, &ed25519_neutral);
+            for (unsigned int i = 0; i < n; i++){
+                ed25519_smult_bounded(&t, pp[i], wp[i], MSM_BENCH_BITS);
+                ed25519_add_assign(&r, &t);
+            }
+            double t2 = wall_clock() - st;
+
+            printf(", separate %f seconds, speedup %.1fx", t2, t2 / t1);
+        }
+
+        printf("\n");
+    }
+
+out:
+    free(pts);
+    free(w);
+    free(pp);
+    free(wp);
+    free(buckets);
+}
+#endif
+
+#if FE_BENCH
+//Time DLOG_BENCH_QUERIES decryption queries of random sums, solved one
+//at a time and then as one batch, and check both give the same answers
+void dlogBatchBench(struct dlog_service *svc, uint64_t bound){
+    struct ed25519_pt *q = malloc(DLOG_BENCH_QUERIES * sizeof(*q));
+    uint64_t *want = malloc(DLOG_BENCH_QUERIES * sizeof(*want));
+    uint64_t *got = malloc(DLOG_BENCH_QUERIES * sizeof(*got));
+    uint8_t *found = malloc(DLOG_BENCH_QUERIES);
+    int bad = 0;
+
+    if (!q || !want || !got || !found){
+        printf("Not enough memory for %d queries\n", DLOG_BENCH_QUERIES);
+        goto out;
+    }
+
+    for (int i = 0; i < DLOG_BENCH_QUERIES; i++){
+        uint8_t e[ED25519_EXPONENT_SIZE];
+
+        want[i] = (uint64_t)rand() % (bound + 1);
+        f25519_load(e, (uint32_t)want[i]);
+        ed25519_smult_bounded(&q[i], &svc->table.base, e, 32);
+    }
+
+    double st = wall_clock();
+    for (int i = 0; i < DLOG_BENCH_QUERIES; i++)
+        if (!dlog_solve(&svc->table, &q[i], bound, &got[i]) || got[i] != want[i])
+            bad++;
+    double t1 = wall_clock() - st;
+
+    st = wall_clock();
+    dlog_service_solve(svc, q, DLOG_BENCH_QUERIES, bound, got, found);
+    double t2 = wall_clock() - st;
+
+    for (int i = 0; i < DLOG_BENCH_QUERIES; i++)
+        if (!found[i] || got[i] != want[i])
+            bad++;
+
+    printf("%d queries: one at a time %.0f/s, batched %.0f/s, speedup %.2fx, %s\n",
+           DLOG_BENCH_QUERIES, DLOG_BENCH_QUERIES / t1, DLOG_BENCH_QUERIES / t2,
+           t1 / t2, bad ? "MISMATCH" : "answers match");
+
+out:
+    free(q);
+    free(want);
+    free(got);
+    free(found);
+}
+#endif
+
+#if FE_BENCH
+//Time DLOG_BENCH_QUERIES epochs of a slowly drifting sum, decrypted from
+//scratch and then seeded with the previous epoch's result
+void dlogNearBench(const struct dlog_table *tbl, uint64_t bound){
+    struct ed25519_pt *q = malloc(DLOG_BENCH_QUERIES * sizeof(*q));
+    uint64_t *want = malloc(DLOG_BENCH_QUERIES * sizeof(*want));
+    uint64_t sum = bound / 2, got, prev;
+    int bad = 0;
+
+    if (!q || !want){
+        printf("Not enough memory for %d epochs\n", DLOG_BENCH_QUERIES);
+        goto out;
+    }
+
+    for (int i = 0; i < DLOG_BENCH_QUERIES; i++){
+        uint8_t e[ED25519_EXPONENT_SIZE];
+
+        sum += rand() % (2 * EPOCH_DRIFT + 1);
+        sum -= EPOCH_DRIFT;
+        want[i] = sum;
+        f25519_load(e, (uint32_t)sum);
+        ed25519_smult_bounded(&q[i], &tbl->base, e, 32);
+    }
+
+    double st = wall_clock();
+    for (int i = 0; i < DLOG_BENCH_QUERIES; i++)
+        if (!dlog_solve(tbl, &q[i], bound, &got) || got != want[i])
+            bad++;
+    double t1 = wall_clock() - st;
+
+    prev = bound / 2;
+    st = wall_clock();
+    for (int i = 0; i < DLOG_BENCH_QUERIES; i++){
+        if (!dlog_solve_near(tbl, &q[i], prev, DLOG_NEAR_DELTA, bound, &got) || got != want[i])
+            bad++;
+        prev = got;
+    }
+    double t2 = wall_clock() - st;
+
+    printf("%d epochs: from scratch %f seconds, from previous sum %f seconds, speedup %.2fx, %s\n",
+           DLOG_BENCH_QUERIES, t1, t2, t1 / t2, bad ? "MISMATCH" : "answers match");
+
+    //Drifts of DLOG_NEAR_DELTA, beyond one table's width, in both directions
+    for (int up = 1; up >= 0; up--){
+        uint64_t d = (uint64_t)DLOG_NEAR_DELTA, hint = bound / 2;
+        uint64_t v = up ? hint + d : hint - d;
+        uint8_t e[ED25519_EXPONENT_SIZE];
+        struct ed25519_pt p;
+
+        f25519_load(e, (uint32_t)v);
+        ed25519_smult_bounded(&p, &tbl->base, e, 32);
+
+        st = wall_clock();
+        int ok = dlog_solve_near(tbl, &p, hint, DLOG_NEAR_DELTA, bound, &got) && got == v;
+        printf("Drift %c%d from the previous sum: %f seconds, %s\n", up ? '+' : '-',
+               DLOG_NEAR_DELTA, wall_clock() - st, ok ? "answer matches" : "MISMATCH");
+    }
+
+out:
+    free(q);
+    free(want);
+}
+#endif
+
+#if FE_BENCH
+//Time PK_BENCH_EPOCHS epochs of mask computation for PK_BENCH_USERS users,
+//each with a fresh r, on the variable-base path and with cached per-key
+//tables, and check both give the same masks
+void pkCacheBench(Experim *users){
+    struct pk_cache cache;
+
+    if (!pk_cache_init(&cache, PK_CACHE_BUDGET)){
+        printf("Not enough memory for the public-key cache\n");
+        return;
+    }
+
+    for (int e = 0; e < PK_BENCH_EPOCHS; e++){
+        uint8_t r[F25519_SIZE];
+        struct ed25519_scalar_prep rPrep;
+        struct ed25519_pt m1, m2;
+        uint8_t x1[F25519_SIZE], y1[F25519_SIZE], x2[F25519_SIZE], y2[F25519_SIZE];
+        double t1 = 0, t2 = 0;
+        int bad = 0;
+
+        genKey(r);
+        ed25519_prepare_scalar(&rPrep, r);
+
+        for (int i = 0; i < PK_BENCH_USERS && i < CNT; i++){
+            double st = wall_clock();
+            _EncryptOffline(&users[i].pkey, &rPrep, &m1);
+            t1 += wall_clock() - st;
+
+            st = wall_clock();
+            _EncryptOfflineCached(&cache, i, &users[i].pkey, &rPrep, &m2);
+            t2 += wall_clock() - st;
+
+            ed25519_unproject(x1, y1, &m1);
+            ed25519_unproject(x2, y2, &m2);
+            bad += memcmp(x1, x2, F25519_SIZE) || memcmp(y1, y2, F25519_SIZE);
+        }
+
+        printf("Epoch %d: variable base %f seconds, cached tables %f seconds, speedup %.2fx, %s\n",
+               e, t1, t2, t1 / t2, bad ? "MISMATCH" : "masks match");
+    }
+
+    printf("Public-key cache: %lu hit(s), %lu miss(es), %lu table(s) of %lu bytes\n",
+           cache.hits, cache.misses, (unsigned long)cache.used,
+           (unsigned long)sizeof(struct ed25519_fixed_table));
+
+    pk_cache_destroy(&cache);
+}
+#endif
 
 PROCESS(sum_FE, "Functional Encryption Process");
 AUTOSTART_PROCESSES(&sum_FE);
@@ -154,6 +712,14 @@ PROCESS_THREAD(sum_FE, ev, data){
 
     Experim Test1[CNT];                     //Initate number of users for the experiments
 
+    //Argument list for the batched scalar operations
+    const uint8_t *bScalar[CNT];
+
+    if (!tpool_init(&pool, FE_THREADS)){
+        printf("Could not start %d worker thread(s)\n", FE_THREADS);
+        PROCESS_EXIT();
+    }
+
     srand(882099);
     printf("========= WELCOME TO THE SUMFE APPLICATION =============\n");
     printf("Lets Begin\n");
@@ -169,36 +735,95 @@ PROCESS_THREAD(sum_FE, ev, data){
     clock_t st1 = clock();
     
     for (int i = 0; i < CNT; i++){
-        genKey(Test1[i].skey);
+        fe_keygen_user(Test1[i].skey, KEYGEN_SEED, i);
         //printf("\nUser %d's ", i);
         //show_str("Secret Key ", Test1[i].skey, F25519_SIZE);
+    }
+
+#if KEYGEN_MONT
+    //Convert G once, then run every key on the ladder
+    struct ed25519_mont_base mG;
+    ed25519_mont_prepare(&mG, &G);
 
-        computePoint(Test1[i].skey, &G, &Test1[i].pkey);
-        //show_point("Public Key", &Test1[i].pkey);
+    for (int i = 0; i < CNT; i++){
+        ed25519_smult_mont(&Test1[i].pkey, &mG, Test1[i].skey);
     }
+#else
+    //Compute all public keys with batched scalar multiplications
+    struct ed25519_pt *bOut[CNT];
+    const struct ed25519_pt *bBase[CNT];
+
+    for (int i = 0; i < CNT; i++){
+        bOut[i] = &Test1[i].pkey;
+        bBase[i] = &G;
+        bScalar[i] = Test1[i].skey;
+    }
+
+    ed25519_smult_batch(bOut, bBase, bScalar, CNT);
+#endif
 
     clock_t et1 = clock();
     double tt1 = ((double) (et1 - st1)) / CLOCKS_PER_SEC;
     printf("\nTime Taken to Generate %d Key Pair(s) -- (Setup): %f seconds\n", CNT, tt1);
 
+    //Repeat the setup with the user range split across the pool, and check
+    //it gives the same key pairs
+    static uint8_t pSkey[CNT][F25519_SIZE];
+    static struct ed25519_pt pPkey[CNT];
+    uint8_t *pSkeyP[CNT];
+    struct ed25519_pt *pPkeyP[CNT];
+    int keysMatch = 1;
+
+    for (int i = 0; i < CNT; i++){
+        pSkeyP[i] = pSkey[i];
+        pPkeyP[i] = &pPkey[i];
+    }
+
+    double stKP = wall_clock();
+    fe_keygen_parallel(&pool, KEYGEN_SEED, pSkeyP, pPkeyP, &G, CNT);
+    double ttKP = wall_clock() - stKP;
+
+    for (int i = 0; i < CNT; i++){
+        uint8_t x1[F25519_SIZE], y1[F25519_SIZE], x2[F25519_SIZE], y2[F25519_SIZE];
+
+        ed25519_unproject(x1, y1, &Test1[i].pkey);
+        ed25519_unproject(x2, y2, &pPkey[i]);
+        if (memcmp(pSkey[i], Test1[i].skey, F25519_SIZE) ||
+            memcmp(x1, x2, F25519_SIZE) || memcmp(y1, y2, F25519_SIZE))
+            keysMatch = 0;
+    }
+
+    printf("Time Taken to Generate %d Key Pair(s) on %d thread(s) -- (Parallel Setup): %f seconds, keys %s\n",
+           CNT, FE_THREADS, ttKP, keysMatch ? "match" : "MISMATCH");
+
+#if FE_BENCH
+    smultBatchBench(&G);
+#endif
+
     //Generate random plaintext values
     printf("\n========== Plaintext Inputs =============\n");
     uint8_t _sum[F25519_SIZE];
     struct ed25519_pt plainT;
 
     for (int j = 0; j < CNT; j++){
-        uint8_t unloaded_x = rand() & 75;
-        f25519_load(Test1[j].plain, unloaded_x);
+        Test1[j].value = rand() & 75;
+#if PLAIN_SIGNED
+        Test1[j].value -= PLAIN_CENTER;
+#endif
+        loadPlaintext(Test1[j].plain, Test1[j].value);
 
         //printf("User %d's ", j);
         //show_str("x_1", Test1[j].plain, F25519_SIZE);
 
     }
 
-    f25519_copy(_sum, Test1[0].plain);
-     for (int i = 1; i < CNT; i ++){
-        _addBigInt(Test1[i].plain, _sum, _sum);
+    //Sum the plaintexts mod l, in native words
+    uint32_t sumS[SC25519_WORDS];
+    for (int i = 0; i < CNT; i++){
+        bScalar[i] = Test1[i].plain;
     }
+    sc25519_sum(sumS, bScalar, CNT);
+    sc25519_to_bytes(_sum, sumS);
 
     show_str("Sum of Plaintexts", _sum, F25519_SIZE);
     computePoint(_sum, &G, &plainT);
@@ -209,29 +834,57 @@ PROCESS_THREAD(sum_FE, ev, data){
     uint8_t r[F25519_SIZE];
     struct ed25519_pt rG;
 
+    //Precompute the plaintext encodings, once for every epoch
+    static struct ed25519_affine plainTable[PLAIN_TABLE];
+
+    clock_t stP = clock();
+    ed25519_affine_table(plainTable, &G, PLAIN_TABLE);
+    clock_t etP = clock();
+    printf("\nTime Taken to build a %d-entry plaintext table: %f seconds\n", PLAIN_TABLE,
+           ((double) (etP - stP)) / CLOCKS_PER_SEC);
+
     printf("\n========== Encryption Process =============\n");
     //compute r and rG
     clock_t st2 = clock();
     genKey(r);
     //show_str("r", r, F25519_SIZE);
 
-    computePoint(r, &G, &rG);
+    //Recode r once for the whole epoch
+    struct ed25519_scalar_prep rPrep;
+    ed25519_prepare_scalar(&rPrep, r);
+
+    ed25519_smult_prepared(&rG, &G, &rPrep);
     //show_point("P (rG)", &rG);
 
+    //Offline: the masks, before any reading is available
+    for (int i = 0; i < CNT; i++){
+        _EncryptOffline(&Test1[i].pkey, &rPrep, &Test1[i].mask);
+    }
+
+    clock_t etO = clock();
+    printf("\nTime Taken to precompute %d mask(s) -- (Encryption, offline): %f seconds\n", CNT,
+           ((double) (etO - st2)) / CLOCKS_PER_SEC);
+
+    //Online: map each reading and add its mask
+    clock_t stN = clock();
     for (int i = 0; i < CNT; i++){
         // Perform the Mapping
-        computePoint(Test1[i].plain, &G, &Test1[i].x_map);
-        //show_point("X_i (Mapped)", &Test1[i].x_map);
+        mapPlaintext(Test1[i].value, plainTable, &Test1[i].x_map);
+        //show_str("X_i (Mapped) y+x", Test1[i].x_map.yplusx, F25519_SIZE);
 
         //Encrypt
-        _Encrypt(&Test1[i].x_map, &Test1[i].pkey, &Test1[i].C, r);
+        _EncryptOnline(&Test1[i].x_map, &Test1[i].mask, &Test1[i].C);
         //printf("\n");
     }
 
     clock_t et2 = clock();
-    double tt2 = ((double) (et2 - st2)) / CLOCKS_PER_SEC;
+    double tt2 = ((double) (et2 - stN)) / CLOCKS_PER_SEC;
     printf("\nTime Taken to Encrypt %d plaintext(s) -- (Encryption): %f seconds\n", CNT, tt2);
 
+#if FE_BENCH
+    pkCacheBench(Test1);
+#endif
+
 
     // //==================================================
     // // Decryption Process
@@ -240,7 +893,7 @@ PROCESS_THREAD(sum_FE, ev, data){
     // clock_t st3 = clock();
 
     // for (int i = 0; i < CNT; i++){
-    //     _Decrypt(Test1[i].skey, &rG, &Test1[i].C);
+    //     _Decrypt(Test1[i].skey, &rG, &Test1[i].C, &svc, PLAIN_MAX, &result);
     // }
 
     // clock_t et3 = clock();
@@ -249,46 +902,264 @@ PROCESS_THREAD(sum_FE, ev, data){
     
     //FE Key Generation Process
     printf("\n========== FE Key Generation Process =============\n");
-    clock_t stK = clock();
+    double stK = wall_clock();
     uint8_t fdk[F25519_SIZE];
-    f25519_copy(fdk, Test1[0].skey);
+    uint32_t fdkS[SC25519_WORDS];
 
-    for (int i = 1; i < CNT; i ++){
-        _addBigInt(Test1[i].skey, fdk, fdk);
+    for (int i = 0; i < CNT; i++){
+        bScalar[i] = Test1[i].skey;
     }
+    fe_fdk_parallel(&pool, fdkS, bScalar, CNT);
+    sc25519_to_bytes(fdk, fdkS);
 
-    clock_t etK = clock();
+    double etK = wall_clock();
     show_str("FDK", fdk, F25519_SIZE);
 
-    double ttK = ((double) (etK - stK)) / CLOCKS_PER_SEC;
+    double ttK = etK - stK;
     printf("\nTime Taken to generate a Decryption Key -- (KeyGen) for %d user(s): %f seconds\n", CNT, ttK);
 
+    printf("\n========== FE Key Generation Scaling (%d users) =============\n", FDK_BENCH_USERS);
+    fdkScaling();
+
 
 
     //==================================================
     //FE Decryption Process
     printf("\n========== FE Ciphertext Decryption Process =============\n");    
     struct ed25519_pt cT;
+    int64_t result;
+
+    //Start the decryption service, mapping the stored baby-step table or
+    //building one for recovering the sum
+    struct dlog_service svc;
+
+    clock_t stT = clock();
+    if (!dlog_service_init(&svc, &pool, DLOG_BABY_STEPS, DLOG_TABLE_FILE, &G)){
+        printf("Not enough memory for the discrete-log table\n");
+        tpool_destroy(&pool);
+        PROCESS_EXIT();
+    }
+    clock_t etT = clock();
+    printf("Time Taken to %s a %lu-entry discrete-log table: %f seconds\n", svc.mapped ? "map" : "build",
+           (unsigned long)svc.table.m, ((double) (etT - stT)) / CLOCKS_PER_SEC);
+
+#if FE_BENCH
+    dlogBatchBench(&svc, (uint64_t)CNT * PLAIN_MAX);
+#endif
+#if FE_BENCH
+    dlogNearBench(&svc.table, (uint64_t)CNT * PLAIN_MAX);
+#endif
+
+    signedWideCheck(&svc, &G);
 
     clock_t st4 = clock();
     
-    ed25519_copy(&cT, &Test1[0].C);
+    //Every ciphertext has arrived, so sum them on the pool and record the
+    //whole range of users as contributors at once
+    static uint8_t contributors[FE_ACCUM_BITMAP_SIZE(CNT)];
+    static struct ed25519_pt cts[CNT];
+    struct fe_accum acc;
+    struct ed25519_pt cS;
+
+    fe_accum_init(&acc, contributors, CNT);
 
     // show_str("x_1 + x_2", _sum, F25519_SIZE);
     // show_str("FDK", fdk, F25519_SIZE);
 
-    for (int i = 1; i < CNT; i ++){
-        //_addBigInt(Test1[i].skey, fdk, fdk);
-        _addPoints(&Test1[i].C, &cT, &cT);
+    for (int i = 0; i < CNT; i ++){
+        ed25519_copy(&cts[i], &Test1[i].C);
+    }
+
+    fe_point_sum_parallel(&pool, &cS, cts, CNT);
+    fe_accum_absorb_range(&acc, 0, CNT, &cS);
+
+    if (!fe_accum_finalize(&acc, NULL, &cT)){
+        printf("Only %lu of %d ciphertext(s) received\n", (unsigned long)acc.count, CNT);
+        dlog_service_destroy(&svc);
+        tpool_destroy(&pool);
+        PROCESS_EXIT();
     }
 
     show_point("Ciphertexts Sum", &cT);
-    _Decrypt(fdk, &rG, &cT);
+    if (_Decrypt(fdk, &rG, &cT, &svc, (uint64_t)CNT * PLAIN_MAX, &result))
+        printf("Decrypted Sum = %ld\n", (long)result);
+    else
+        printf("Decrypted Sum is not in [%ld, %lu]\n", PLAIN_SIGNED ? -(long)CNT * PLAIN_MAX : 0L,
+               (unsigned long)CNT * PLAIN_MAX);
     clock_t et4 = clock();
 
     double tt4 = ((double) (et4 - st4)) / CLOCKS_PER_SEC;
     printf("\nTime Taken to execute FE Decryption -- (Decryption) for %d ciphertext(s): %f seconds\n", CNT, tt4);
 
+    //==================================================
+    //Decryption with dropouts: the key authority keeps the roster's FDK, and
+    //subtracts the keys of the members whose ciphertexts never arrived
+    printf("\n========== FE Decryption with Dropouts =============\n");
+    static uint8_t roster[FE_ACCUM_BITMAP_SIZE(CNT)];
+    static uint8_t reported[FE_ACCUM_BITMAP_SIZE(CNT)];
+    struct fe_members members;
+    struct fe_accum round;
+    uint32_t fdkDS[SC25519_WORDS];
+    uint8_t fdkD[F25519_SIZE];
+    struct ed25519_pt cD;
+    const uint8_t *bMember[CNT];
+    uint32_t fdkRS[SC25519_WORDS];
+    int64_t partial = 0;
+    int nMember = 0;
+
+    fe_members_init(&members, roster, CNT, fdkS);
+    fe_accum_init(&round, reported, CNT);
+
+    //The roster changes by one leave and one join, and its FDK must still
+    //match the sum of its members' keys
+#if ROSTER_JOIN != ROSTER_LEAVE
+    fe_members_leave(&members, ROSTER_JOIN, Test1[ROSTER_JOIN].skey);
+#endif
+    if (!fe_members_leave(&members, ROSTER_LEAVE, Test1[ROSTER_LEAVE].skey) ||
+        !fe_members_join(&members, ROSTER_JOIN, Test1[ROSTER_JOIN].skey))
+        printf("Roster change rejected\n");
+
+    for (int i = 0; i < CNT; i++){
+        if (fe_members_has(&members, i))
+            bMember[nMember++] = Test1[i].skey;
+    }
+    sc25519_sum(fdkRS, bMember, nMember);
+    printf("User %d left and user %d joined, %lu member(s), FDK %s\n", ROSTER_LEAVE, ROSTER_JOIN,
+           (unsigned long)members.count, memcmp(fdkRS, members.fdk, sizeof(fdkRS)) ? "MISMATCH" : "matches");
+
+    for (int i = 0; i < CNT; i++){
+        bScalar[i] = Test1[i].skey;
+        if (!fe_members_has(&members, i) || i % DROPOUT_STRIDE == DROPOUT_STRIDE - 1)
+            continue;
+
+        fe_accum_absorb(&round, i, &Test1[i].C);
+        partial += Test1[i].value;
+    }
+
+    printf("%lu of %d user(s) reported, Sum of their Plaintexts = %ld\n",
+           (unsigned long)round.count, CNT, (long)partial);
+
+    double stD = wall_clock();
+    int keyOk = fe_members_round_key(&members, &round, bScalar, fdkDS);
+    sc25519_to_bytes(fdkD, fdkDS);
+    double etD = wall_clock();
+
+    printf("Time Taken to adjust the FDK for %lu dropout(s): %f seconds\n",
+           (unsigned long)(members.count - round.count), etD - stD);
+
+    if (!keyOk)
+        printf("Round key not derived: a ciphertext came from a non-member\n");
+    else if (!fe_accum_finalize(&round, reported, &cD))
+        printf("Contributors of the %lu ciphertext(s) don't match the round key\n",
+               (unsigned long)round.count);
+    else if (_Decrypt(fdkD, &rG, &cD, &svc, (uint64_t)round.count * PLAIN_MAX, &result))
+        printf("Decrypted Sum = %ld\n", (long)result);
+    else
+        printf("Decrypted Sum is not in [%ld, %lu]\n", PLAIN_SIGNED ? -(long)round.count * PLAIN_MAX : 0L,
+               (unsigned long)round.count * PLAIN_MAX);
+
+    //==================================================
+    //Hierarchical aggregation: each gateway sums its own users' ciphertexts
+    //and forwards one packed partial aggregate, which the aggregator checks
+    //for well-formedness and merges. The gateways are trusted to sum
+    //honestly (see fe-accum.h).
+    printf("\n========== Hierarchical Aggregation (%d gateways) =============\n", GATEWAYS);
+    static uint8_t gwSeen[GATEWAYS][FE_ACCUM_BITMAP_SIZE(CNT)];
+    static uint8_t gwWire[GATEWAYS][FE_ACCUM_WIRE_SIZE(CNT)];
+    static uint8_t upSeen[FE_ACCUM_BITMAP_SIZE(CNT)];
+    static uint8_t totalSeen[FE_ACCUM_BITMAP_SIZE(CNT)];
+    struct fe_accum gw[GATEWAYS];
+    struct fe_accum up, total;
+    struct ed25519_pt cH;
+    int merged = 0;
+
+    for (int g = 0; g < GATEWAYS; g++)
+        fe_accum_init(&gw[g], gwSeen[g], CNT);
+
+    for (int i = 0; i < CNT; i++)
+        fe_accum_absorb(&gw[i % GATEWAYS], i, &Test1[i].C);
+
+    for (int g = 0; g < GATEWAYS; g++)
+        fe_accum_pack(&gw[g], gwWire[g]);
+
+    double stH = wall_clock();
+    fe_accum_init(&total, totalSeen, CNT);
+    for (int g = 0; g < GATEWAYS; g++){
+        if (fe_accum_unpack(&up, upSeen, CNT, gwWire[g]) && fe_accum_merge(&total, &up))
+            merged++;
+    }
+    double etH = wall_clock();
+
+    printf("Merged %d of %d partial aggregate(s) of %d bytes each: %f seconds\n",
+           merged, GATEWAYS, (int)FE_ACCUM_WIRE_SIZE(CNT), etH - stH);
+
+    //A replayed aggregate shares its contributors with the one already merged
+    if (fe_accum_unpack(&up, upSeen, CNT, gwWire[0]) && !fe_accum_merge(&total, &up))
+        printf("Replayed partial aggregate rejected\n");
+
+    if (!fe_accum_finalize(&total, NULL, &cH))
+        printf("Only %lu of %d ciphertext(s) reached the aggregator\n", (unsigned long)total.count, CNT);
+    else if (_Decrypt(fdk, &rG, &cH, &svc, (uint64_t)CNT * PLAIN_MAX, &result))
+        printf("Decrypted Sum = %ld\n", (long)result);
+    else
+        printf("Decrypted Sum is not in [%ld, %lu]\n", PLAIN_SIGNED ? -(long)CNT * PLAIN_MAX : 0L,
+               (unsigned long)CNT * PLAIN_MAX);
+
+#if FE_BENCH
+    printf("\n========== Ciphertext Aggregation Scaling (%d ciphertexts) =============\n", SUM_BENCH_POINTS);
+    sumScaling(&G);
+#endif
+
+    //==================================================
+    //Weighted Sum Decryption: sum(w_i x_i) from the same ciphertexts, with
+    //the key FDK_w = sum(w_i s_i) mod l and sum(w_i C_i) evaluated as one
+    //multi-scalar multiplication
+    printf("\n========== FE Weighted Sum Decryption =============\n");
+    static uint8_t weights[CNT][SC25519_SIZE];
+    static struct ed25519_pt buckets[MSM_BUCKETS(WEIGHT_BITS)];
+    const struct ed25519_pt *bC[CNT];
+    const uint8_t *bW[CNT];
+    uint32_t fdkWS[SC25519_WORDS];
+    uint8_t fdkW[F25519_SIZE];
+    struct ed25519_pt cW;
+    int64_t weighted = 0;
+
+    for (int i = 0; i < CNT; i++){
+        weights[i][0] = 1 + i % WEIGHT_MAX;
+        weighted += (int64_t)weights[i][0] * Test1[i].value;
+
+        bW[i] = weights[i];
+        bC[i] = &Test1[i].C;
+        bScalar[i] = Test1[i].skey;
+    }
+
+    printf("Weighted Sum of Plaintexts = %ld\n", (long)weighted);
+
+    clock_t stW = clock();
+    sc25519_dot(fdkWS, bW, bScalar, CNT);
+    sc25519_to_bytes(fdkW, fdkWS);
+
+    msm_eval(&cW, bC, bW, CNT, WEIGHT_BITS, buckets, MSM_BUCKETS(WEIGHT_BITS));
+
+    if (_Decrypt(fdkW, &rG, &cW, &svc, (uint64_t)CNT * PLAIN_MAX * WEIGHT_MAX, &result))
+        printf("Decrypted Weighted Sum = %ld\n", (long)result);
+    else
+        printf("Decrypted Weighted Sum is not in [%ld, %lu]\n",
+               PLAIN_SIGNED ? -(long)CNT * PLAIN_MAX * WEIGHT_MAX : 0L,
+               (unsigned long)CNT * PLAIN_MAX * WEIGHT_MAX);
+    clock_t etW = clock();
+
+    printf("\nTime Taken to execute FE Weighted Decryption for %d ciphertext(s): %f seconds\n", CNT, ((double) (etW - stW)) / CLOCKS_PER_SEC);
+
+#if FE_BENCH
+    printf("\n========== Multi-Scalar Multiplication Scaling =============\n");
+    msmScaling(&G);
+#endif
+
+    dlog_service_destroy(&svc);
+
+    tpool_destroy(&pool);
+
     energest_flush();
 
     printf("\nEnergest Measurements:\n");
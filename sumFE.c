@@ -2,7 +2,12 @@
 #include "c25519.h"
 #include "ed25519.h"
 #include "f25519.h"
-#include "ecc.h"
+#include "sc25519.h"
+#include "dlog.h"
+#include "fe-accum.h"
+#include "fe-keygen.h"
+#include "fe-members.h"
+#include "msm.h"
 #include "energest.h"
 
 
@@ -17,12 +22,63 @@
 #define CNT 2
 
 
+//Plaintext magnitudes whose encodings m*G are precomputed, so mapping a
+//plaintext is a constant-time table scan instead of a scalar multiplication
+#define PLAIN_TABLE (PLAIN_MAX + 1)
+
+//Largest plaintext (rand() & 75), so the sum is at most CNT * PLAIN_MAX
+#define PLAIN_MAX 75
+
+//Set to 1 for signed plaintexts (rand() & 75) - PLAIN_CENTER, such as
+//corrections, whose sum is recovered from [-CNT * PLAIN_MAX, CNT * PLAIN_MAX]
+#ifndef PLAIN_SIGNED
+#define PLAIN_SIGNED 0
+#endif
+#define PLAIN_CENTER 37
+
+//Weights of the weighted-sum query, 1 .. WEIGHT_MAX by tariff band (user
+//index mod WEIGHT_MAX), so the weighted sum is at most CNT * PLAIN_MAX *
+//WEIGHT_MAX. WEIGHT_BITS is the number of bits WEIGHT_MAX needs.
+#define WEIGHT_MAX 4
+#define WEIGHT_BITS 3
+
+//Users i with i % DROPOUT_STRIDE == DROPOUT_STRIDE - 1 miss the dropout
+//round, whose sum is decrypted over the users who did report
+#define DROPOUT_STRIDE 2
+
+//Before the dropout round, user ROSTER_LEAVE leaves the roster, and user
+//ROSTER_JOIN joins it. With only two users, both are user 0 re-registering,
+//so that user 1 is still a member who misses the round.
+#define ROSTER_JOIN 0
+#define ROSTER_LEAVE 0
+
+//Gateways between the users and the aggregator; user i reports to
+//gateway i % GATEWAYS
+#define GATEWAYS 2
+
+//Baby steps in the table used to recover the sum from sum*G
+#define DLOG_BABY_STEPS 16
+
+//Set to 1 to derive public keys on the X-only Montgomery ladder instead
+//of the Edwards double-and-add, for benchmarking the two paths
+#ifndef KEYGEN_MONT
+#define KEYGEN_MONT 0
+#endif
+
+//Seed of the per-user key streams, so every run generates the same key
+//pairs as the native simulator's parallel setup
+#ifndef KEYGEN_SEED
+#define KEYGEN_SEED 882099
+#endif
+
 //Definition of a ciphertext
 typedef struct {
     uint8_t skey[F25519_SIZE];
-    uint8_t plain[F25519_SIZE];
+    int32_t value;                  //plaintext
+    uint8_t plain[F25519_SIZE];     //plaintext mod l
     struct ed25519_pt pkey;
-    struct ed25519_pt x_map;
+    struct ed25519_affine x_map;
+    struct ed25519_pt mask;
     struct ed25519_pt C;
 } Experim;
 
@@ -75,26 +131,52 @@ int computePoint(uint8_t *inB, struct ed25519_pt *inP, struct ed25519_pt *outP)
     return 1;
 }
 
-//Function to encrypt a message
-int _Encrypt(struct ed25519_pt *msg, struct ed25519_pt *pk, struct ed25519_pt *C, uint8_t *r) {
-    struct ed25519_pt rY;
-    struct ed25519_pt res;
+//Function to map a small signed plaintext onto the curve, as |v|*G from
+//the table of encodings, negated if v < 0. The cost depends only on
+//PLAIN_TABLE, not on the plaintext value.
+int mapPlaintext(int32_t v, const struct ed25519_affine *table, struct ed25519_affine *out) {
+    const uint32_t neg = (uint32_t)v >> 31;
 
-    //compute rY
-    ed25519_smult(&rY, pk, r);
+    ed25519_affine_lookup(out, table, PLAIN_TABLE, (v ^ -neg) + neg);
+    ed25519_affine_cneg(out, neg);
+    return 1;
+}
 
-    //compute M + rY
-    ed25519_add(&res, msg, &rY);
-    //show_point("Q (M + rY)", &res);
+//Function to store a signed plaintext as a scalar mod l
+void loadPlaintext(uint8_t *out, int32_t v){
+    uint32_t s[SC25519_WORDS];
+    uint32_t zero[SC25519_WORDS];
 
-    //copy contents of res into the second component of the Ciphertext struct
-    ed25519_copy(C, &res);
+    sc25519_load(s, v < 0 ? -(uint32_t)v : (uint32_t)v);
+    if (v < 0){
+        sc25519_load(zero, 0);
+        sc25519_sub(s, zero, s);
+    }
+    sc25519_to_bytes(out, s);
+}
 
+//Function to precompute the data-independent half of an encryption, the
+//mask r*pk_i (equal to s_i*rG), e.g. while the radio is idle. r is recoded
+//once per epoch with ed25519_prepare_scalar() and shared by every user.
+int _EncryptOffline(struct ed25519_pt *pk, const struct ed25519_scalar_prep *r, struct ed25519_pt *mask) {
+    ed25519_smult_prepared(mask, pk, r);
     return 1;
 }
 
-//Function to decrypt the ciphertext
-int _Decrypt(uint8_t *sk, struct ed25519_pt *rG, struct ed25519_pt *C){
+//Function to encrypt a message once the reading is available: one mixed
+//addition of the mapped plaintext to the precomputed mask, C = M + rY
+int _EncryptOnline(const struct ed25519_affine *msg, const struct ed25519_pt *mask, struct ed25519_pt *C) {
+    ed25519_add_affine(C, mask, msg);
+    //show_point("Q (M + rY)", C);
+
+    return 1;
+}
+
+//Function to decrypt the ciphertext. Recovers the integer m from the
+//decrypted point m*G, with 0 <= m <= bound (-bound <= m <= bound if
+//PLAIN_SIGNED), returning 0 if there is none.
+int _Decrypt(uint8_t *sk, struct ed25519_pt *rG, struct ed25519_pt *C,
+             const struct dlog_table *tbl, uint64_t bound, int64_t *m){
     uint8_t negS[F25519_SIZE], rY_x[F25519_SIZE], rY_y[F25519_SIZE];
     struct ed25519_pt rY;
     struct ed25519_pt _rY;
@@ -113,37 +195,27 @@ int _Decrypt(uint8_t *sk, struct ed25519_pt *rG, struct ed25519_pt *C){
     //Compute res = -sP + Q
     ed25519_add(&res, C, &_rY);
     show_point("Decrypted M", &res);
-    
-    return 1;
-}
 
-//Function to add 2 points on the Twisted Edwards Curve
-int _addPoints(struct ed25519_pt *in1, struct ed25519_pt *in2, struct ed25519_pt *out){
-    struct ed25519_pt res;
+#if PLAIN_SIGNED
+    return dlog_solve_signed(tbl, &res, bound, m);
+#else
+    uint64_t v;
 
-    ed25519_add(&res, in1, in2);
-    ed25519_copy(out, &res);
+    if (!dlog_solve(tbl, &res, bound, &v))
+        return 0;
 
+    *m = (int64_t)v;
     return 1;
+#endif
 }
 
-int _addBigInt(uint8_t *key1, uint8_t *key2, uint8_t *outkey){
-    unsigned int k1[NUM_ECC_WORDS];
-    unsigned int k2[NUM_ECC_WORDS];
-    unsigned int out[NUM_ECC_WORDS];
-
-    //Convert uint8_t to uECC_word for the private key
-    uECC_vli_bytesToNative(k1, key1, BITS_TO_BYTES(256));
-    uECC_vli_bytesToNative(k2, key2, BITS_TO_BYTES(256));
-
-    uECC_vli_add(out, k1, k2, NUM_ECC_WORDS);
-
-    //Convert uECC word to uint8_t
-    uECC_vli_nativeToBytes(outkey, BITS_TO_BYTES(256), out);
+//Function to add 2 points on the Twisted Edwards Curve
+//(out may alias either input)
+int _addPoints(struct ed25519_pt *in1, struct ed25519_pt *in2, struct ed25519_pt *out){
+    ed25519_add(out, in1, in2);
 
     return 1;
-
-} 
+}
 
 PROCESS(sum_FE, "Functional Encryption Process");
 AUTOSTART_PROCESSES(&sum_FE);
@@ -153,6 +225,9 @@ PROCESS_THREAD(sum_FE, ev, data){
 
     Experim Test1[CNT];                     //Initate number of users for the experiments
 
+    //Argument list for the batched scalar operations
+    const uint8_t *bScalar[CNT];
+
     srand(882099);
     printf("========= WELCOME TO THE SUMFE APPLICATION =============\n");
     printf("Lets Begin\n");
@@ -168,11 +243,29 @@ PROCESS_THREAD(sum_FE, ev, data){
     clock_time_t st1 = clock_time();
     
     for (int i = 0; i < CNT; i++){
-        genKey(Test1[i].skey);
+        fe_keygen_user(Test1[i].skey, KEYGEN_SEED, i);
         printf("\nUser %d's ", i);
         show_str("Secret Key ", Test1[i].skey, F25519_SIZE);
+    }
+
+#if KEYGEN_MONT
+    //Convert G once, then run every key on the ladder
+    struct ed25519_mont_base mG;
+    ed25519_mont_prepare(&mG, &G);
 
+    for (int i = 0; i < CNT; i++){
+        ed25519_smult_mont(&Test1[i].pkey, &mG, Test1[i].skey);
+    }
+#else
+    //One key at a time: ed25519_smult_batch() needs about 2.6 KB of stack
+    //per lane, too much for the process stack on the node
+    for (int i = 0; i < CNT; i++){
         computePoint(Test1[i].skey, &G, &Test1[i].pkey);
+    }
+#endif
+
+    for (int i = 0; i < CNT; i++){
+        printf("User %d's ", i);
         show_point("Public Key", &Test1[i].pkey);
     }
 
@@ -186,18 +279,24 @@ PROCESS_THREAD(sum_FE, ev, data){
     struct ed25519_pt plainT;
 
     for (int j = 0; j < CNT; j++){
-        uint8_t unloaded_x = rand() & 75;
-        f25519_load(Test1[j].plain, unloaded_x);
+        Test1[j].value = rand() & 75;
+#if PLAIN_SIGNED
+        Test1[j].value -= PLAIN_CENTER;
+#endif
+        loadPlaintext(Test1[j].plain, Test1[j].value);
 
         printf("User %d's ", j);
         show_str("x_1", Test1[j].plain, F25519_SIZE);
 
     }
 
-    f25519_copy(_sum, Test1[0].plain);
-     for (int i = 1; i < CNT; i ++){
-        _addBigInt(Test1[i].plain, _sum, _sum);
+    //Sum the plaintexts mod l, in native words
+    uint32_t sumS[SC25519_WORDS];
+    for (int i = 0; i < CNT; i++){
+        bScalar[i] = Test1[i].plain;
     }
+    sc25519_sum(sumS, bScalar, CNT);
+    sc25519_to_bytes(_sum, sumS);
 
     show_str("Sum of Plaintexts", _sum, F25519_SIZE);
     computePoint(_sum, &G, &plainT);
@@ -208,27 +307,49 @@ PROCESS_THREAD(sum_FE, ev, data){
     uint8_t r[F25519_SIZE];
     struct ed25519_pt rG;
 
+    //Precompute the plaintext encodings, once for every epoch
+    static struct ed25519_affine plainTable[PLAIN_TABLE];
+
+    clock_time_t stP = clock_time();
+    ed25519_affine_table(plainTable, &G, PLAIN_TABLE);
+    clock_time_t etP = clock_time();
+    printf("\nTime Taken to build a %d-entry plaintext table: %lu ticks\n", PLAIN_TABLE, (unsigned long)(etP - stP));
+
     printf("\n========== Encryption Process =============\n");
     //compute r and rG
     clock_time_t st2 = clock_time();
     genKey(r);
     show_str("r", r, F25519_SIZE);
 
-    computePoint(r, &G, &rG);
+    //Recode r once for the whole epoch
+    struct ed25519_scalar_prep rPrep;
+    ed25519_prepare_scalar(&rPrep, r);
+
+    ed25519_smult_prepared(&rG, &G, &rPrep);
     show_point("P (rG)", &rG);
 
+    //Offline: the masks, before any reading is available
+    for (int i = 0; i < CNT; i++){
+        _EncryptOffline(&Test1[i].pkey, &rPrep, &Test1[i].mask);
+    }
+
+    clock_time_t etO = clock_time();
+    printf("\nTime Taken to precompute %d mask(s) -- (Encryption, offline): %lu ticks\n", CNT, (unsigned long)(etO - st2));
+
+    //Online: map each reading and add its mask
+    clock_time_t stN = clock_time();
     for (int i = 0; i < CNT; i++){
         // Perform the Mapping
-        computePoint(Test1[i].plain, &G, &Test1[i].x_map);
-        show_point("X_i (Mapped)", &Test1[i].x_map);
+        mapPlaintext(Test1[i].value, plainTable, &Test1[i].x_map);
+        show_str("X_i (Mapped) y+x", Test1[i].x_map.yplusx, F25519_SIZE);
 
         //Encrypt
-        _Encrypt(&Test1[i].x_map, &Test1[i].pkey, &Test1[i].C, r);
+        _EncryptOnline(&Test1[i].x_map, &Test1[i].mask, &Test1[i].C);
         printf("\n");
     }
 
     clock_time_t et2 = clock_time();
-    unsigned long tt2 = et2 - st2;
+    unsigned long tt2 = et2 - stN;
     printf("\nTime Taken to Encrypt %d plaintext(s) -- (Encryption): %lu ticks\n", CNT, tt2);
 
 
@@ -239,7 +360,7 @@ PROCESS_THREAD(sum_FE, ev, data){
     // clock_time_t st3 = clock_time();
 
     // for (int i = 0; i < CNT; i++){
-    //     _Decrypt(Test1[i].skey, &rG, &Test1[i].C);
+    //     _Decrypt(Test1[i].skey, &rG, &Test1[i].C, &tbl, PLAIN_MAX, &result);
     // }
 
     // clock_time_t et3 = clock_time();
@@ -250,11 +371,13 @@ PROCESS_THREAD(sum_FE, ev, data){
     printf("\n========== FE Key Generation Process =============\n");
     clock_time_t stK = clock_time();
     uint8_t fdk[F25519_SIZE];
-    f25519_copy(fdk, Test1[0].skey);
+    uint32_t fdkS[SC25519_WORDS];
 
-    for (int i = 1; i < CNT; i ++){
-        _addBigInt(Test1[i].skey, fdk, fdk);
+    for (int i = 0; i < CNT; i++){
+        bScalar[i] = Test1[i].skey;
     }
+    sc25519_sum(fdkS, bScalar, CNT);
+    sc25519_to_bytes(fdk, fdkS);
 
     clock_time_t etK = clock_time();
     show_str("FDK", fdk, F25519_SIZE);
@@ -268,26 +391,203 @@ PROCESS_THREAD(sum_FE, ev, data){
     //FE Decryption Process
     printf("\n========== FE Ciphertext Decryption Process =============\n");    
     struct ed25519_pt cT;
+    int64_t result;
+
+    //Build the baby-step table for recovering the sum
+    static struct dlog_entry dlogSlots[DLOG_TABLE_SLOTS(DLOG_BABY_STEPS)];
+    struct dlog_table tbl;
+
+    clock_time_t stT = clock_time();
+    dlog_table_build(&tbl, dlogSlots, DLOG_BABY_STEPS, &G);
+    clock_time_t etT = clock_time();
+    printf("Time Taken to build a %d-entry discrete-log table: %lu ticks\n", DLOG_BABY_STEPS, (unsigned long)(etT - stT));
 
     clock_time_t st4 = clock_time();
     
-    ed25519_copy(&cT, &Test1[0].C);
+    //Fold the ciphertexts into the sum as they arrive, tracking who sent them
+    static uint8_t contributors[FE_ACCUM_BITMAP_SIZE(CNT)];
+    struct fe_accum acc;
+
+    fe_accum_init(&acc, contributors, CNT);
 
     // show_str("x_1 + x_2", _sum, F25519_SIZE);
     // show_str("FDK", fdk, F25519_SIZE);
 
-    for (int i = 1; i < CNT; i ++){
-        //_addBigInt(Test1[i].skey, fdk, fdk);
-        _addPoints(&Test1[i].C, &cT, &cT);
+    for (int i = 0; i < CNT; i ++){
+        fe_accum_absorb(&acc, i, &Test1[i].C);
+    }
+
+    if (!fe_accum_finalize(&acc, NULL, &cT)){
+        printf("Only %lu of %d ciphertext(s) received\n", (unsigned long)acc.count, CNT);
+        PROCESS_EXIT();
     }
 
     show_point("Ciphertexts Sum", &cT);
-    _Decrypt(fdk, &rG, &cT);
+    if (_Decrypt(fdk, &rG, &cT, &tbl, (uint64_t)CNT * PLAIN_MAX, &result))
+        printf("Decrypted Sum = %ld\n", (long)result);
+    else
+        printf("Decrypted Sum is not in [%ld, %lu]\n", PLAIN_SIGNED ? -(long)CNT * PLAIN_MAX : 0L,
+               (unsigned long)CNT * PLAIN_MAX);
     clock_time_t et4 = clock_time();
 
     unsigned long tt4 = et4 - st4;
     printf("\nTime Taken to execute FE Decryption -- (Decryption) for %d ciphertext(s): %lu ticks\n", CNT, tt4);
 
+    //==================================================
+    //Decryption with dropouts: the key authority keeps the roster's FDK, and
+    //subtracts the keys of the members whose ciphertexts never arrived
+    printf("\n========== FE Decryption with Dropouts =============\n");
+    static uint8_t roster[FE_ACCUM_BITMAP_SIZE(CNT)];
+    static uint8_t reported[FE_ACCUM_BITMAP_SIZE(CNT)];
+    struct fe_members members;
+    struct fe_accum round;
+    uint32_t fdkDS[SC25519_WORDS];
+    uint8_t fdkD[F25519_SIZE];
+    struct ed25519_pt cD;
+    const uint8_t *bMember[CNT];
+    uint32_t fdkRS[SC25519_WORDS];
+    int64_t partial = 0;
+    int nMember = 0;
+
+    fe_members_init(&members, roster, CNT, fdkS);
+    fe_accum_init(&round, reported, CNT);
+
+    //The roster changes by one leave and one join, and its FDK must still
+    //match the sum of its members' keys
+#if ROSTER_JOIN != ROSTER_LEAVE
+    fe_members_leave(&members, ROSTER_JOIN, Test1[ROSTER_JOIN].skey);
+#endif
+    if (!fe_members_leave(&members, ROSTER_LEAVE, Test1[ROSTER_LEAVE].skey) ||
+        !fe_members_join(&members, ROSTER_JOIN, Test1[ROSTER_JOIN].skey))
+        printf("Roster change rejected\n");
+
+    for (int i = 0; i < CNT; i++){
+        if (fe_members_has(&members, i))
+            bMember[nMember++] = Test1[i].skey;
+    }
+    sc25519_sum(fdkRS, bMember, nMember);
+    printf("User %d left and user %d joined, %lu member(s), FDK %s\n", ROSTER_LEAVE, ROSTER_JOIN,
+           (unsigned long)members.count, memcmp(fdkRS, members.fdk, sizeof(fdkRS)) ? "MISMATCH" : "matches");
+
+    for (int i = 0; i < CNT; i++){
+        bScalar[i] = Test1[i].skey;
+        if (!fe_members_has(&members, i) || i % DROPOUT_STRIDE == DROPOUT_STRIDE - 1)
+            continue;
+
+        fe_accum_absorb(&round, i, &Test1[i].C);
+        partial += Test1[i].value;
+    }
+
+    printf("%lu of %d user(s) reported, Sum of their Plaintexts = %ld\n",
+           (unsigned long)round.count, CNT, (long)partial);
+
+    clock_time_t stD = clock_time();
+    int keyOk = fe_members_round_key(&members, &round, bScalar, fdkDS);
+    sc25519_to_bytes(fdkD, fdkDS);
+    clock_time_t etD = clock_time();
+
+    printf("Time Taken to adjust the FDK for %lu dropout(s): %lu ticks\n",
+           (unsigned long)(members.count - round.count), (unsigned long)(etD - stD));
+
+    if (!keyOk)
+        printf("Round key not derived: a ciphertext came from a non-member\n");
+    else if (!fe_accum_finalize(&round, reported, &cD))
+        printf("Contributors of the %lu ciphertext(s) don't match the round key\n",
+               (unsigned long)round.count);
+    else if (_Decrypt(fdkD, &rG, &cD, &tbl, (uint64_t)round.count * PLAIN_MAX, &result))
+        printf("Decrypted Sum = %ld\n", (long)result);
+    else
+        printf("Decrypted Sum is not in [%ld, %lu]\n", PLAIN_SIGNED ? -(long)round.count * PLAIN_MAX : 0L,
+               (unsigned long)round.count * PLAIN_MAX);
+
+    //==================================================
+    //Hierarchical aggregation: each gateway sums its own users' ciphertexts
+    //and forwards one packed partial aggregate, which the aggregator checks
+    //for well-formedness and merges. The gateways are trusted to sum
+    //honestly (see fe-accum.h).
+    printf("\n========== Hierarchical Aggregation (%d gateways) =============\n", GATEWAYS);
+    static uint8_t gwSeen[GATEWAYS][FE_ACCUM_BITMAP_SIZE(CNT)];
+    static uint8_t gwWire[GATEWAYS][FE_ACCUM_WIRE_SIZE(CNT)];
+    static uint8_t upSeen[FE_ACCUM_BITMAP_SIZE(CNT)];
+    static uint8_t totalSeen[FE_ACCUM_BITMAP_SIZE(CNT)];
+    struct fe_accum gw[GATEWAYS];
+    struct fe_accum up, total;
+    struct ed25519_pt cH;
+    int merged = 0;
+
+    for (int g = 0; g < GATEWAYS; g++)
+        fe_accum_init(&gw[g], gwSeen[g], CNT);
+
+    for (int i = 0; i < CNT; i++)
+        fe_accum_absorb(&gw[i % GATEWAYS], i, &Test1[i].C);
+
+    for (int g = 0; g < GATEWAYS; g++)
+        fe_accum_pack(&gw[g], gwWire[g]);
+
+    clock_time_t stH = clock_time();
+    fe_accum_init(&total, totalSeen, CNT);
+    for (int g = 0; g < GATEWAYS; g++){
+        if (fe_accum_unpack(&up, upSeen, CNT, gwWire[g]) && fe_accum_merge(&total, &up))
+            merged++;
+    }
+    clock_time_t etH = clock_time();
+
+    printf("Merged %d of %d partial aggregate(s) of %d bytes each: %lu ticks\n",
+           merged, GATEWAYS, (int)FE_ACCUM_WIRE_SIZE(CNT), (unsigned long)(etH - stH));
+
+    //A replayed aggregate shares its contributors with the one already merged
+    if (fe_accum_unpack(&up, upSeen, CNT, gwWire[0]) && !fe_accum_merge(&total, &up))
+        printf("Replayed partial aggregate rejected\n");
+
+    if (!fe_accum_finalize(&total, NULL, &cH))
+        printf("Only %lu of %d ciphertext(s) reached the aggregator\n", (unsigned long)total.count, CNT);
+    else if (_Decrypt(fdk, &rG, &cH, &tbl, (uint64_t)CNT * PLAIN_MAX, &result))
+        printf("Decrypted Sum = %ld\n", (long)result);
+    else
+        printf("Decrypted Sum is not in [%ld, %lu]\n", PLAIN_SIGNED ? -(long)CNT * PLAIN_MAX : 0L,
+               (unsigned long)CNT * PLAIN_MAX);
+
+    //==================================================
+    //Weighted Sum Decryption: sum(w_i x_i) from the same ciphertexts, with
+    //the key FDK_w = sum(w_i s_i) mod l and sum(w_i C_i) evaluated as one
+    //multi-scalar multiplication
+    printf("\n========== FE Weighted Sum Decryption =============\n");
+    static uint8_t weights[CNT][SC25519_SIZE];
+    static struct ed25519_pt buckets[MSM_BUCKETS(WEIGHT_BITS)];
+    const struct ed25519_pt *bC[CNT];
+    const uint8_t *bW[CNT];
+    uint32_t fdkWS[SC25519_WORDS];
+    uint8_t fdkW[F25519_SIZE];
+    struct ed25519_pt cW;
+    int64_t weighted = 0;
+
+    for (int i = 0; i < CNT; i++){
+        weights[i][0] = 1 + i % WEIGHT_MAX;
+        weighted += (int64_t)weights[i][0] * Test1[i].value;
+
+        bW[i] = weights[i];
+        bC[i] = &Test1[i].C;
+        bScalar[i] = Test1[i].skey;
+    }
+
+    printf("Weighted Sum of Plaintexts = %ld\n", (long)weighted);
+
+    clock_time_t stW = clock_time();
+    sc25519_dot(fdkWS, bW, bScalar, CNT);
+    sc25519_to_bytes(fdkW, fdkWS);
+
+    msm_eval(&cW, bC, bW, CNT, WEIGHT_BITS, buckets, MSM_BUCKETS(WEIGHT_BITS));
+
+    if (_Decrypt(fdkW, &rG, &cW, &tbl, (uint64_t)CNT * PLAIN_MAX * WEIGHT_MAX, &result))
+        printf("Decrypted Weighted Sum = %ld\n", (long)result);
+    else
+        printf("Decrypted Weighted Sum is not in [%ld, %lu]\n",
+               PLAIN_SIGNED ? -(long)CNT * PLAIN_MAX * WEIGHT_MAX : 0L,
+               (unsigned long)CNT * PLAIN_MAX * WEIGHT_MAX);
+    clock_time_t etW = clock_time();
+
+    printf("\nTime Taken to execute FE Weighted Decryption for %d ciphertext(s): %lu ticks\n", CNT, (unsigned long)(etW - stW));
+
     energest_flush();
 
     printf("\nEnergest Measurements:\n");
@@ -0,0 +1,71 @@
+/* Generate a discrete-log table file for sumFE decryption
+ *
+ * Usage: dlog-gen <baby steps> <output file>
+ *
+ * This file is in the public domain.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "dlog.h"
+#include "dlog-file.h"
+#include "fe-parallel.h"
+
+int main(int argc, char **argv)
+{
+	struct dlog_entry *slots;
+	struct dlog_table t;
+	struct tpool pool;
+	unsigned long m;
+	long ncpu;
+	int ok;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s <baby steps> <output file>\n",
+			argv[0]);
+		return 2;
+	}
+
+	m = strtoul(argv[1], NULL, 0);
+	if (!m || m > 0x7fffffffUL) {
+		fprintf(stderr, "bad number of baby steps: %s\n", argv[1]);
+		return 2;
+	}
+
+	slots = malloc(DLOG_TABLE_SLOTS((size_t)m) * sizeof(*slots));
+	if (!slots) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (!tpool_init(&pool, ncpu > 0 ? ncpu : 1)) {
+		fprintf(stderr, "can't start threads\n");
+		free(slots);
+		return 1;
+	}
+
+	dlog_table_init(&t, slots, NULL, m, &ed25519_base);
+	ok = fe_dlog_build_parallel(&pool, &t);
+	tpool_destroy(&pool);
+
+	if (!ok) {
+		fprintf(stderr, "table build failed\n");
+		free(slots);
+		return 1;
+	}
+
+	if (!dlog_file_save(argv[2], &t, &ed25519_base)) {
+		fprintf(stderr, "%s: write failed\n", argv[2]);
+		free(slots);
+		return 1;
+	}
+
+	printf("%s: %lu baby steps, %lu slots\n", argv[2], m,
+	       (unsigned long)t.nslots);
+
+	free(slots);
+	return 0;
+}
@@ -0,0 +1,114 @@
+/* Fixed-size worker thread pool
+ *
+ * This file is in the public domain.
+ */
+
+#include <stddef.h>
+
+#include "tpool.h"
+
+static void *tpool_worker_main(void *varg)
+{
+	struct tpool_worker *w = varg;
+	struct tpool *p = w->pool;
+	unsigned long seen = 0;
+
+	for (;;) {
+		tpool_fn fn;
+		void *arg;
+
+		pthread_mutex_lock(&p->lock);
+		while (!p->stop && p->generation == seen)
+			pthread_cond_wait(&p->start, &p->lock);
+
+		if (p->stop) {
+			pthread_mutex_unlock(&p->lock);
+			return NULL;
+		}
+
+		seen = p->generation;
+		fn = p->fn;
+		arg = p->arg;
+		pthread_mutex_unlock(&p->lock);
+
+		fn(arg, w->idx, p->nthreads);
+
+		pthread_mutex_lock(&p->lock);
+		if (!--p->pending)
+			pthread_cond_signal(&p->done);
+		pthread_mutex_unlock(&p->lock);
+	}
+}
+
+int tpool_init(struct tpool *p, unsigned int nthreads)
+{
+	unsigned int i;
+
+	if (nthreads < 1)
+		nthreads = 1;
+	if (nthreads > TPOOL_MAX_THREADS)
+		nthreads = TPOOL_MAX_THREADS;
+
+	p->nthreads = 1;
+	p->generation = 0;
+	p->pending = 0;
+	p->stop = 0;
+	p->fn = NULL;
+	p->arg = NULL;
+
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->start, NULL);
+	pthread_cond_init(&p->done, NULL);
+
+	/* Slot 0 is the calling thread */
+	for (i = 1; i < nthreads; i++) {
+		struct tpool_worker *w = &p->workers[i];
+
+		w->pool = p;
+		w->idx = i;
+
+		if (pthread_create(&w->thread, NULL, tpool_worker_main, w)) {
+			tpool_destroy(p);
+			return 0;
+		}
+
+		p->nthreads = i + 1;
+	}
+
+	return 1;
+}
+
+void tpool_run(struct tpool *p, tpool_fn fn, void *arg)
+{
+	pthread_mutex_lock(&p->lock);
+	p->fn = fn;
+	p->arg = arg;
+	p->pending = p->nthreads - 1;
+	p->generation++;
+	pthread_cond_broadcast(&p->start);
+	pthread_mutex_unlock(&p->lock);
+
+	fn(arg, 0, p->nthreads);
+
+	pthread_mutex_lock(&p->lock);
+	while (p->pending)
+		pthread_cond_wait(&p->done, &p->lock);
+	pthread_mutex_unlock(&p->lock);
+}
+
+void tpool_destroy(struct tpool *p)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&p->lock);
+	p->stop = 1;
+	pthread_cond_broadcast(&p->start);
+	pthread_mutex_unlock(&p->lock);
+
+	for (i = 1; i < p->nthreads; i++)
+		pthread_join(p->workers[i].thread, NULL);
+
+	pthread_cond_destroy(&p->done);
+	pthread_cond_destroy(&p->start);
+	pthread_mutex_destroy(&p->lock);
+}
@@ -0,0 +1,69 @@
+/* Fixed-size worker thread pool
+ *
+ * This file is in the public domain.
+ */
+
+#ifndef TPOOL_H_
+#define TPOOL_H_
+
+#include <pthread.h>
+
+/* A pool of nthreads - 1 worker threads, plus the calling thread. Work
+ * is fork-join: tpool_run() calls fn(arg, idx, nthreads) once for
+ * every idx in [0, nthreads), and returns when all calls have
+ * returned. idx 0 always runs on the calling thread.
+ *
+ * This needs POSIX threads, and so is only built for the native
+ * target.
+ */
+#ifndef TPOOL_MAX_THREADS
+#define TPOOL_MAX_THREADS  64
+#endif
+
+typedef void (*tpool_fn)(void *arg, unsigned int idx,
+			 unsigned int nthreads);
+
+struct tpool;
+
+struct tpool_worker {
+	pthread_t        thread;
+	struct tpool    *pool;
+	unsigned int     idx;
+};
+
+struct tpool {
+	unsigned int         nthreads;
+	struct tpool_worker  workers[TPOOL_MAX_THREADS];
+	pthread_mutex_t      lock;
+	pthread_cond_t       start;
+	pthread_cond_t       done;
+	unsigned long        generation;
+	unsigned int         pending;
+	int                  stop;
+	tpool_fn             fn;
+	void                *arg;
+};
+
+/* Start the workers. nthreads is clamped to [1, TPOOL_MAX_THREADS].
+ * Returns 1 on success, 0 if the threads could not be created.
+ */
+int tpool_init(struct tpool *p, unsigned int nthreads);
+
+/* Run one parallel job and wait for it to finish */
+void tpool_run(struct tpool *p, tpool_fn fn, void *arg);
+
+/* Stop and join the workers */
+void tpool_destroy(struct tpool *p);
+
+/* Split [0, n) into nthreads contiguous ranges of near-equal size, and
+ * return the bounds of range idx.
+ */
+static inline void tpool_range(unsigned int n, unsigned int idx,
+			       unsigned int nthreads,
+			       unsigned int *begin, unsigned int *end)
+{
+	*begin = (unsigned int)(((unsigned long long)n * idx) / nthreads);
+	*end = (unsigned int)(((unsigned long long)n * (idx + 1)) / nthreads);
+}
+
+#endif